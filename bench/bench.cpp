@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+// Runs each solver executable repeatedly and reports timing statistics.
+//
+// Usage: bench [-n runs] [-i input] [-v] [solver...]
+//
+// By default every solver is run on its own checked in input. Solvers report their phase
+// stats (see common/phase.h) down a pipe whose descriptor is passed in AOC_PHASE_FD.
+// With -v every phase a solver reports (including sub-phases like "P1/gravity") is broken
+// out underneath it with CPU time, allocations and peak RSS.
+
+struct Solver {
+  const char* name;
+  const char* executable;
+  const char* default_input;
+};
+
+const std::vector<Solver> solvers = {
+#include "solvers.inc"
+};
+
+const std::vector<std::string> reported_phases = {"parse", "P1", "P2"};
+
+struct Phase {
+  double wall_ms = 0;
+  double cpu_ms = 0;
+  double allocs = 0;
+  double alloc_mb = 0;
+  double peak_rss_mb = 0;
+};
+
+struct Run {
+  double wall_ms;
+  std::map<std::string, Phase> phases;
+};
+
+std::optional<Run> run_once(const Solver& s, const std::string& input) {
+  int fds[2];
+  if (pipe(fds) != 0) return std::nullopt;
+
+  const auto start = std::chrono::steady_clock::now();
+
+  const pid_t pid = fork();
+  if (pid < 0) return std::nullopt;
+
+  if (pid == 0) {
+    // Child: discard the solver's own output and hand it the write end of the pipe.
+    close(fds[0]);
+    const int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, STDOUT_FILENO);
+    const std::string fd = std::to_string(fds[1]);
+    setenv("AOC_PHASE_FD", fd.c_str(), 1);
+    execl(s.executable, s.executable, input.c_str(), static_cast<char*>(nullptr));
+    _exit(127);
+  }
+
+  close(fds[1]);
+  std::string report;
+  char buf[4096];
+  ssize_t n;
+  while ((n = read(fds[0], buf, sizeof(buf))) > 0) report.append(buf, n);
+  close(fds[0]);
+
+  int status;
+  waitpid(pid, &status, 0);
+  const auto end = std::chrono::steady_clock::now();
+
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) return std::nullopt;
+
+  Run run;
+  run.wall_ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+  std::stringstream ss(report);
+  std::string name;
+  long long wall_ns, cpu_ns, peak_rss_kb;
+  unsigned long long allocs, alloc_bytes;
+  while (ss >> name >> wall_ns >> cpu_ns >> allocs >> alloc_bytes >> peak_rss_kb) {
+    auto& phase = run.phases[name];
+    phase.wall_ms += wall_ns / 1e6;
+    phase.cpu_ms += cpu_ns / 1e6;
+    phase.allocs += allocs;
+    phase.alloc_mb += alloc_bytes / 1e6;
+    phase.peak_rss_mb = std::max(phase.peak_rss_mb, peak_rss_kb / 1e3);
+  }
+
+  return run;
+}
+
+// Nearest rank percentile of an already sorted sample.
+double percentile(const std::vector<double>& sorted, double p) {
+  const std::size_t rank = std::ceil(p * sorted.size());
+  return sorted[std::max<std::size_t>(rank, 1) - 1];
+}
+
+template<typename F>
+double median(const std::vector<Phase>& phases, F field) {
+  std::vector<double> values;
+  for (const auto& p : phases) values.push_back(field(p));
+  std::sort(values.begin(), values.end());
+  return percentile(values, 0.5);
+}
+
+void usage() {
+  std::fprintf(stderr, "Usage: bench [-n runs] [-i input] [-v] [solver...]\nSolvers:");
+  for (const auto& s : solvers) std::fprintf(stderr, " %s", s.name);
+  std::fprintf(stderr, "\n");
+  std::exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv) {
+  int num_runs = 10;
+  std::string input;
+  bool verbose = false;
+  std::vector<const Solver*> selected;
+
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      num_runs = std::atoi(argv[++i]);
+      if (num_runs < 1) usage();
+    }
+    else if (std::strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+      input = argv[++i];
+    }
+    else if (std::strcmp(argv[i], "-v") == 0) {
+      verbose = true;
+    }
+    else {
+      const auto it = std::find_if(solvers.begin(), solvers.end(), [&] (const Solver& s) {
+        return std::strcmp(s.name, argv[i]) == 0;
+      });
+      if (it == solvers.end()) usage();
+      selected.push_back(&*it);
+    }
+  }
+
+  if (selected.empty()) {
+    for (const auto& s : solvers) selected.push_back(&s);
+  }
+
+  std::printf("%-8s %6s %10s %10s %10s", "solver", "runs", "min ms", "median ms", "p99 ms");
+  for (const auto& phase : reported_phases) std::printf(" %10s", (phase + " ms").c_str());
+  std::printf("\n");
+
+  bool all_ok = true;
+  for (const Solver* s : selected) {
+    const std::string solver_input = input.empty() ? s->default_input : input;
+
+    std::vector<double> wall;
+    std::map<std::string, std::vector<Phase>> phases;
+    for (int i = 0; i < num_runs; i++) {
+      const auto run = run_once(*s, solver_input);
+      if (!run) break;
+
+      wall.push_back(run->wall_ms);
+      for (const auto& [name, phase] : run->phases) phases[name].push_back(phase);
+    }
+
+    if (static_cast<int>(wall.size()) != num_runs) {
+      std::printf("%-8s failed\n", s->name);
+      all_ok = false;
+      continue;
+    }
+
+    std::sort(wall.begin(), wall.end());
+    std::printf("%-8s %6d %10.3f %10.3f %10.3f",
+      s->name, num_runs, wall.front(), percentile(wall, 0.5), percentile(wall, 0.99));
+
+    for (const auto& name : reported_phases) {
+      const auto it = phases.find(name);
+      if (it == phases.end()) {
+        std::printf(" %10s", "-");
+        continue;
+      }
+
+      std::printf(" %10.3f", median(it->second, [] (const Phase& p) { return p.wall_ms; }));
+    }
+
+    std::printf("\n");
+
+    if (verbose) {
+      std::printf("  %-26s %10s %10s %12s %10s %10s\n",
+        "phase", "wall ms", "cpu ms", "allocs", "alloc MB", "rss MB");
+      for (const auto& [name, samples] : phases) {
+        std::printf("  %-26s %10.3f %10.3f %12.0f %10.3f %10.1f\n",
+          name.c_str(),
+          median(samples, [] (const Phase& p) { return p.wall_ms; }),
+          median(samples, [] (const Phase& p) { return p.cpu_ms; }),
+          median(samples, [] (const Phase& p) { return p.allocs; }),
+          median(samples, [] (const Phase& p) { return p.alloc_mb; }),
+          median(samples, [] (const Phase& p) { return p.peak_rss_mb; }));
+      }
+    }
+  }
+
+  return all_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
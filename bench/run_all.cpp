@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "input.h"
+#include "solvers.h"
+#include "work_stealing.h"
+
+// Runs every solver in process, all at once, on a work-stealing pool. Solvers fork their
+// independent halves (e.g. the two searches in d17) onto the same pool.
+//
+// Usage: run_all [-j threads] [-n copies] [solver...]
+//
+// Each selected solver is run `copies` times (default 1) on its own checked in input. For
+// every job it reports the wall time, the total work and the critical path (span), then the
+// makespan of the whole batch and how busy each worker was.
+
+struct DefaultInput {
+  const char* name;
+  const char* path;
+};
+
+const std::vector<DefaultInput> default_inputs = {
+#include "inputs.inc"
+};
+
+using Clock = std::chrono::steady_clock;
+
+struct Job {
+  const aoc::SolverEntry* solver;
+  std::string_view input;
+  aoc::Answer answer;
+  Clock::time_point start;
+  Clock::time_point end;
+  aoc::WorkStealingPool::JobStats stats;
+};
+
+double ms(std::int64_t ns) { return ns / 1e6; }
+
+double ms(Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); }
+
+void usage() {
+  std::fprintf(stderr, "Usage: run_all [-j threads] [-n copies] [solver...]\nSolvers:");
+  for (const auto& s : aoc::all_solvers()) std::fprintf(stderr, " %s", s.name);
+  std::fprintf(stderr, "\n");
+  std::exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv) {
+  std::size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+  int num_copies = 1;
+  std::vector<const aoc::SolverEntry*> selected;
+
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      const int n = std::atoi(argv[++i]);
+      if (n < 1) usage();
+      num_threads = n;
+    }
+    else if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      num_copies = std::atoi(argv[++i]);
+      if (num_copies < 1) usage();
+    }
+    else {
+      const aoc::SolverEntry* s = aoc::find_solver(argv[i]);
+      if (!s) usage();
+      selected.push_back(s);
+    }
+  }
+
+  if (selected.empty()) {
+    for (const auto& s : aoc::all_solvers()) selected.push_back(&s);
+  }
+
+  // Map all of the inputs up front so that only solving is timed.
+  std::vector<std::unique_ptr<aoc::Input>> inputs;
+  std::vector<Job> jobs;
+  for (const auto* s : selected) {
+    const auto it = std::find_if(default_inputs.begin(), default_inputs.end(), [s] (const DefaultInput& d) {
+      return std::strcmp(d.name, s->name) == 0;
+    });
+    if (it == default_inputs.end()) usage();
+
+    inputs.push_back(std::make_unique<aoc::Input>(it->path));
+    for (int i = 0; i < num_copies; i++) {
+      jobs.push_back(Job{s, inputs.back()->data(), {}, {}, {}, {}});
+    }
+  }
+
+  aoc::WorkStealingPool pool(num_threads);
+
+  const auto start = Clock::now();
+  for (Job& job : jobs) {
+    pool.submit(
+      [&job] {
+        job.start = Clock::now();
+        job.answer = job.solver->solve(job.input);
+      },
+      [&job] (const aoc::WorkStealingPool::JobStats& stats) {
+        job.end = Clock::now();
+        job.stats = stats;
+      });
+  }
+  pool.wait();
+  const auto end = Clock::now();
+  pool.join();
+
+  std::printf("%-8s %16s %16s %10s %10s %10s %8s\n",
+    "solver", "P1", "P2", "wall ms", "work ms", "span ms", "par");
+
+  std::int64_t total_work = 0, critical_path = 0;
+  for (const Job& job : jobs) {
+    const auto p1 = job.answer.p1 ? std::to_string(*job.answer.p1) : "-";
+    const auto p2 = job.answer.p2 ? std::to_string(*job.answer.p2) : "-";
+    std::printf("%-8s %16s %16s %10.3f %10.3f %10.3f %8.2f\n",
+      job.solver->name, p1.c_str(), p2.c_str(),
+      ms(job.end - job.start), ms(job.stats.work_ns), ms(job.stats.span_ns),
+      static_cast<double>(job.stats.work_ns) / std::max<std::int64_t>(job.stats.span_ns, 1));
+
+    total_work += job.stats.work_ns;
+    critical_path = std::max(critical_path, job.stats.span_ns);
+  }
+
+  // The jobs are independent, so the critical path of the whole batch is the longest one.
+  std::printf("\nmakespan %.3f ms, total work %.3f ms, critical path %.3f ms (parallelism %.2f)\n",
+    ms(end - start), ms(total_work), ms(critical_path),
+    static_cast<double>(total_work) / std::max<std::int64_t>(critical_path, 1));
+
+  std::printf("\n%-8s %10s %10s %8s %8s %8s\n", "worker", "busy ms", "idle ms", "util", "tasks", "steals");
+  const auto stats = pool.worker_stats();
+  for (std::size_t i = 0; i < stats.size(); i++) {
+    const auto& w = stats[i];
+    const double total = std::max<std::int64_t>(w.busy_ns + w.idle_ns, 1);
+    std::printf("%-8zu %10.3f %10.3f %7.1f%% %8llu %8llu\n",
+      i, ms(w.busy_ns), ms(w.idle_ns), 100 * w.busy_ns / total,
+      static_cast<unsigned long long>(w.tasks_run), static_cast<unsigned long long>(w.steals));
+  }
+
+  return EXIT_SUCCESS;
+}
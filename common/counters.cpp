@@ -0,0 +1,141 @@
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "counters.h"
+#include "phase.h"
+
+namespace {
+
+struct EventInfo {
+  const char* name;
+  std::uint32_t type;
+  std::uint64_t config;
+};
+
+constexpr std::uint64_t cache_read_miss(std::uint64_t cache) {
+  return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+constexpr std::array<EventInfo, aoc::PerfCounters::NUM_EVENTS> events = {{
+  {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+  {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+  {"l1d_misses", PERF_TYPE_HW_CACHE, cache_read_miss(PERF_COUNT_HW_CACHE_L1D)},
+  {"llc_misses", PERF_TYPE_HW_CACHE, cache_read_miss(PERF_COUNT_HW_CACHE_LL)},
+  {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+  {"dtlb_misses", PERF_TYPE_HW_CACHE, cache_read_miss(PERF_COUNT_HW_CACHE_DTLB)}
+}};
+
+bool enabled() {
+  static const bool on = std::getenv("AOC_PERF_COUNTERS") != nullptr;
+  return on;
+}
+
+int open_event(const EventInfo& event) {
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = event.type;
+  attr.config = event.config;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  return syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+// Reads a counter, scaling it up if the kernel had to multiplex it with the others.
+// Returns -1 if it never got scheduled.
+double read_event(int fd) {
+  std::uint64_t values[3];
+  if (read(fd, values, sizeof(values)) != sizeof(values) || values[2] == 0) return -1;
+  return static_cast<double>(values[0]) * values[1] / values[2];
+}
+
+}
+
+namespace aoc {
+
+PerfCounters::PerfCounters(const char* region) : region_(nullptr) {
+  fds_.fill(-1);
+  if (!enabled()) return;
+
+  bool any = false;
+  for (int i = 0; i < NUM_EVENTS; i++) {
+    fds_[i] = open_event(events[i]);
+    any |= fds_[i] >= 0;
+  }
+
+  if (!any) {
+    // Counters can be set up from several pool tasks at once.
+    static std::atomic<bool> warned{false};
+    if (!warned.exchange(true)) std::perror("perf_event_open (counters disabled)");
+    return;
+  }
+
+  region_ = region;
+
+  // Enable them as close together as possible (and last) so that the set up isn't counted.
+  for (int fd : fds_) {
+    if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+  }
+  for (int fd : fds_) {
+    if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+}
+
+void PerfCounters::stop() {
+  for (int fd : fds_) {
+    if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+  }
+
+  if (!region_) return;
+
+  std::array<double, NUM_EVENTS> counts;
+  for (int i = 0; i < NUM_EVENTS; i++) {
+    counts[i] = fds_[i] >= 0 ? read_event(fds_[i]) : -1;
+    if (fds_[i] >= 0) close(fds_[i]);
+    fds_[i] = -1;
+  }
+
+  char buf[1024];
+  int len = 0;
+  const auto append = [&buf, &len] (const char* fmt, auto... args) {
+    len += std::snprintf(buf + len, sizeof(buf) - len, fmt, args...);
+  };
+
+  const int json = json_report_fd();
+  if (json >= 0) {
+    append("{\"solver\":\"%s\",\"region\":\"%s\"", program_invocation_short_name, region_);
+    for (int i = 0; i < NUM_EVENTS; i++) {
+      if (counts[i] < 0) append(",\"%s\":null", events[i].name);
+      else append(",\"%s\":%.0f", events[i].name, counts[i]);
+    }
+    append("}\n");
+    write_report(json, buf, len);
+  }
+  else {
+    // Misses are easiest to compare between regions per thousand instructions.
+    const double kilo_instructions = counts[INSTRUCTIONS] / 1000;
+    append("%s %s:", program_invocation_short_name, region_);
+    for (int i = 0; i < NUM_EVENTS; i++) {
+      if (counts[i] < 0) continue;
+      append(" %s=%.0f", events[i].name, counts[i]);
+      if (i > INSTRUCTIONS && kilo_instructions > 0) append(" (%.2f/ki)", counts[i] / kilo_instructions);
+    }
+    if (counts[CYCLES] > 0 && counts[INSTRUCTIONS] >= 0) append(" ipc=%.2f", counts[INSTRUCTIONS] / counts[CYCLES]);
+    append("\n");
+    write_report(STDERR_FILENO, buf, len);
+  }
+
+  region_ = nullptr;
+}
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace aoc {
+
+// Hardware performance counters (via perf_event_open) around a hot region of a solver, for
+// telling cache bound code apart from branch bound code.
+//
+// Off unless the AOC_PERF_COUNTERS environment variable is set. Each region then reports
+// cycles, instructions, L1D/LLC read misses, branch misses and dTLB read misses when it
+// finishes: as a line of JSON in the AOC_PHASE_JSON file if there is one (see phase.h),
+// otherwise as a summary on stderr. Counters the kernel won't give us (no PMU, or
+// perf_event_paranoid too strict) are left out; if there are none at all the region is a
+// no-op.
+//
+// Regions are meant to wrap a whole loop rather than sit inside one: opening the counters
+// costs a handful of syscalls.
+class PerfCounters {
+public:
+  enum Event { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, BRANCH_MISSES, DTLB_MISSES, NUM_EVENTS };
+
+  explicit PerfCounters(const char* region);
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  ~PerfCounters() { stop(); }
+
+  void stop();
+
+private:
+  const char* region_;
+  std::array<int, NUM_EVENTS> fds_;
+};
+
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace aoc {
+
+// Shared plumbing for the synthetic input generators (dNN_gen).
+//
+// Usage: dNN_gen [scale] [seed]
+//
+// The scale is roughly how many times larger than the real puzzle input the output should
+// be (so 1 gives something comparable to the checked in input.txt). Output goes to stdout
+// and is fully determined by the scale and seed.
+struct GeneratorArgs {
+  double scale;
+  std::mt19937_64 rng;
+};
+
+inline GeneratorArgs parse_generator_args(int argc, char** argv) {
+  if (argc > 3) {
+    std::fprintf(stderr, "Usage: %s [scale] [seed]\n", argv[0]);
+    std::exit(EXIT_FAILURE);
+  }
+
+  const double scale = argc > 1 ? std::atof(argv[1]) : 1.0;
+  const std::uint64_t seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2023;
+  if (scale <= 0) {
+    std::fprintf(stderr, "Scale must be positive\n");
+    std::exit(EXIT_FAILURE);
+  }
+
+  // Outputs can run to hundreds of MB so give stdout a decent buffer.
+  static char buf[1 << 20];
+  std::setvbuf(stdout, buf, _IOFBF, sizeof(buf));
+
+  return GeneratorArgs{scale, std::mt19937_64(seed)};
+}
+
+// Uniform integer in [lo, hi].
+template<typename T>
+T uniform(std::mt19937_64& rng, T lo, T hi) {
+  return std::uniform_int_distribution<T>(lo, hi)(rng);
+}
+
+// Hands out distinct random labels drawn from `alphabet`. Labels start at `min_length`
+// characters and get longer once the shorter ones start running out, up to `max_length`
+// (for solvers that only take labels so long). Once those are running out too, the rest go
+// in order, and running out altogether is an error.
+class LabelPool {
+public:
+  LabelPool(std::string_view alphabet, std::size_t min_length, std::size_t max_length = SIZE_MAX)
+    : alphabet_(alphabet), length_(min_length), max_length_(max_length) {}
+
+  // Reserve a label so that it's never handed out (e.g. fixed labels like "in").
+  void reserve(const std::string& label) { used_.insert(label); }
+
+  std::string next(std::mt19937_64& rng) {
+    std::size_t attempts = 0;
+    while (true) {
+      std::string label;
+      for (std::size_t i = 0; i < length_; i++) {
+        label += alphabet_[uniform<std::size_t>(rng, 0, alphabet_.size() - 1)];
+      }
+
+      if (used_.insert(label).second) return label;
+
+      // Lots of collisions means this length is close to exhausted.
+      if (++attempts == 16) {
+        if (length_ == max_length_) return next_unused();
+        ++length_;
+        attempts = 0;
+      }
+    }
+  }
+
+private:
+  std::string_view alphabet_;
+  std::size_t length_;
+  std::size_t max_length_;
+  std::unordered_set<std::string> used_;
+
+  // The first unused label of the longest length, counting through them like numbers.
+  std::string next_unused() {
+    std::string label(length_, alphabet_[0]);
+    while (!used_.insert(label).second) {
+      std::size_t i = length_;
+      while (i > 0 && label[i - 1] == alphabet_.back()) label[--i] = alphabet_[0];
+      if (i == 0) {
+        std::fprintf(stderr, "Ran out of %zu character labels\n", length_);
+        std::exit(EXIT_FAILURE);
+      }
+      label[i - 1] = alphabet_[alphabet_.find(label[i - 1]) + 1];
+    }
+    return label;
+  }
+};
+
+}
@@ -0,0 +1,42 @@
+#include <algorithm>
+
+#include "grid.h"
+
+namespace aoc {
+
+Grid::Grid(const std::vector<std::string_view>& rows, int padding)
+  : width_(static_cast<int>(rows[0].size())),
+    height_(static_cast<int>(rows.size())),
+    padding_(padding),
+    stride_(width_ + 2 * padding) {
+
+  const std::int32_t row = static_cast<std::int32_t>(stride_);
+  offsets_ = {-row, 1, row, -1};
+
+  cells_.resize(stride_ * (height_ + 2 * padding_));
+}
+
+Grid::Grid(const std::vector<std::string_view>& rows, char sentinel, int padding)
+  : Grid(rows, padding) {
+
+  std::fill(cells_.begin(), cells_.end(), sentinel);
+  for (int y = 0; y < height_; y++) {
+    std::copy(rows[y].begin(), rows[y].end(), cells_.begin() + index(0, y));
+  }
+}
+
+Grid Grid::toroidal(const std::vector<std::string_view>& rows, int padding) {
+  Grid grid(rows, padding);
+
+  // Every cell within `padding` of the map gets whatever the tiling puts there.
+  const auto wrap = [] (int v, int size) { return ((v % size) + size) % size; };
+  for (int y = -padding; y < grid.height_ + padding; y++) {
+    for (int x = -padding; x < grid.width_ + padding; x++) {
+      grid.at(x, y) = rows[wrap(y, grid.height_)][wrap(x, grid.width_)];
+    }
+  }
+
+  return grid;
+}
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace aoc {
+
+// A 2D character map in a single allocation, row after row, with a border `padding` cells
+// deep all the way round. Cells are addressed by a linear index and moving N, E, S or W is
+// just adding the matching entry of offsets(), so a search never has to check x and y
+// against the edges:
+// * by default every border cell holds a sentinel character (e.g. a wall), so a step off
+//   the map lands on something the search already rejects.
+// * toroidal() grids instead fill the border with the opposite edge of the map, as if it
+//   tiled the plane. From any cell on the map, up to `padding` steps read exactly what they
+//   would on the infinite tiling; wrapped_index() brings an unbounded coordinate back onto
+//   the map first.
+class Grid {
+public:
+  using Index = std::uint32_t;
+
+  Grid(const std::vector<std::string_view>& rows, char sentinel, int padding = 1);
+
+  static Grid toroidal(const std::vector<std::string_view>& rows, int padding = 1);
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+
+  // Number of cells, border included. Any Index is below this.
+  std::size_t size() const { return cells_.size(); }
+
+  Index index(int x, int y) const { return (y + padding_) * stride_ + x + padding_; }
+
+  int x(Index i) const { return static_cast<int>(i % stride_) - padding_; }
+  int y(Index i) const { return static_cast<int>(i / stride_) - padding_; }
+
+  // Index of the cell the unbounded coordinate maps onto (only meaningful for toroidal
+  // grids).
+  Index wrapped_index(std::uint32_t x, std::uint32_t y) const {
+    return index(x % width_, y % height_);
+  }
+
+  // What to add to an index to take one step N, E, S and W.
+  const std::array<std::int32_t, 4>& offsets() const { return offsets_; }
+
+  char operator[](Index i) const { return cells_[i]; }
+  char& operator[](Index i) { return cells_[i]; }
+
+  char at(int x, int y) const { return cells_[index(x, y)]; }
+  char& at(int x, int y) { return cells_[index(x, y)]; }
+
+private:
+  int width_;
+  int height_;
+  int padding_;
+  Index stride_;
+
+  std::array<std::int32_t, 4> offsets_;
+  std::vector<char> cells_;
+
+  Grid(const std::vector<std::string_view>& rows, int padding);
+};
+
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+
+namespace aoc {
+
+// Splits a block of text into lines without copying (the trailing newline is dropped).
+class Lines {
+public:
+  class iterator {
+  public:
+    iterator(const char* pos, const char* end) : pos_(pos), end_(end) { find_line_end(); }
+
+    std::string_view operator*() const { return std::string_view(pos_, line_end_ - pos_); }
+
+    iterator& operator++() {
+      pos_ = line_end_ == end_ ? end_ : line_end_ + 1;
+      find_line_end();
+      return *this;
+    }
+
+    bool operator!=(const iterator& other) const { return pos_ != other.pos_; }
+
+  private:
+    const char* pos_;
+    const char* end_;
+    const char* line_end_;
+
+    void find_line_end() {
+      const void* nl = std::memchr(pos_, '\n', end_ - pos_);
+      line_end_ = nl ? static_cast<const char*>(nl) : end_;
+    }
+  };
+
+  explicit Lines(std::string_view text) : text_(text) {}
+
+  iterator begin() const { return iterator(text_.data(), text_.data() + text_.size()); }
+  iterator end() const { return iterator(text_.data() + text_.size(), text_.data() + text_.size()); }
+
+private:
+  std::string_view text_;
+};
+
+// Read-only memory mapping of an input file. Solvers parse straight out of the mapping so
+// there's no need to copy the input line by line.
+class Input {
+public:
+  explicit Input(const char* path) {
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+      std::perror(path);
+      std::exit(EXIT_FAILURE);
+    }
+
+    struct stat st;
+    fstat(fd, &st);
+    size_ = st.st_size;
+
+    // Mapping an empty file fails, but then there's nothing to map anyway.
+    if (size_ > 0) {
+      void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) {
+        std::perror(path);
+        std::exit(EXIT_FAILURE);
+      }
+
+      madvise(p, size_, MADV_SEQUENTIAL);
+      data_ = static_cast<const char*>(p);
+    }
+
+    close(fd);
+  }
+
+  Input(const Input&) = delete;
+  Input& operator=(const Input&) = delete;
+
+  ~Input() {
+    if (data_) munmap(const_cast<char*>(data_), size_);
+  }
+
+  std::string_view data() const { return std::string_view(data_, size_); }
+  Lines lines() const { return Lines(data()); }
+
+private:
+  const char* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+// Pop the next token from the front of `s`, skipping any of the delimiter characters.
+// Returns an empty view once `s` is exhausted.
+inline std::string_view next_token(std::string_view& s, std::string_view delims = " ") {
+  const auto start = s.find_first_not_of(delims);
+  if (start == std::string_view::npos) {
+    s = std::string_view();
+    return s;
+  }
+
+  s.remove_prefix(start);
+  const auto len = std::min(s.find_first_of(delims), s.size());
+  const auto token = s.substr(0, len);
+  s.remove_prefix(len);
+  return token;
+}
+
+template<typename T>
+T to_number(std::string_view s, int base = 10) {
+  T val{};
+  if constexpr (std::is_integral_v<T>) std::from_chars(s.data(), s.data() + s.size(), val, base);
+  else std::from_chars(s.data(), s.data() + s.size(), val);
+  return val;
+}
+
+}
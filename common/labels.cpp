@@ -0,0 +1,17 @@
+#include "labels.h"
+
+namespace aoc {
+
+LabelInterner::LabelInterner(std::string_view alphabet, std::size_t max_width)
+  : radix_(alphabet.size() + 1), max_width_(max_width) {
+
+  for (std::size_t i = 0; i < alphabet.size(); i++) {
+    digits_[static_cast<unsigned char>(alphabet[i])] = static_cast<std::uint8_t>(i + 1);
+  }
+
+  std::size_t num_slots = 1;
+  for (std::size_t i = 0; i < max_width; i++) num_slots *= radix_;
+  ids_.assign(num_slots, none);
+}
+
+}
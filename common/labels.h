@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+#include <vector>
+
+namespace aoc {
+
+// Character sets for LabelInterner.
+constexpr std::string_view lowercase = "abcdefghijklmnopqrstuvwxyz";
+constexpr std::string_view uppercase_and_digits = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+// Hands out dense ids (0, 1, 2, ... in order of first appearance) for the short labels that
+// name the nodes of a puzzle's graph, so nodes can live in a vector and refer to each other
+// by id rather than by comparing strings.
+//
+// Labels are at most `max_width` characters from `alphabet`. Reading one as a number in
+// base (alphabet size + 1), with 0 meaning "no character", gives every possible label its
+// own slot in a table: a perfect hash, so a lookup is a few multiply-adds and one load.
+// The table has a slot for every possible label, so this is only for short ones (three
+// lowercase letters is 27^3 slots). Any other label is a bug in the caller and aborts.
+class LabelInterner {
+public:
+  static constexpr std::uint32_t none = ~0u;
+
+  LabelInterner(std::string_view alphabet, std::size_t max_width);
+
+  // The label's id, giving it the next free one if it hasn't been seen before.
+  std::uint32_t intern(std::string_view label) {
+    std::uint32_t& id = ids_[hash(label)];
+    if (id == none) {
+      id = static_cast<std::uint32_t>(labels_.size());
+      labels_.push_back(label);
+    }
+    return id;
+  }
+
+  // The label's id, or `none` if it hasn't been interned.
+  std::uint32_t find(std::string_view label) const { return ids_[hash(label)]; }
+
+  // The label with the given id. This is a view of whatever text was interned, so it's only
+  // valid for as long as that is.
+  std::string_view label(std::uint32_t id) const { return labels_[id]; }
+
+  std::size_t size() const { return labels_.size(); }
+
+private:
+  // 1 + the character's position in the alphabet, 0 if it isn't in it.
+  std::array<std::uint8_t, 256> digits_{};
+  std::size_t radix_;
+  std::size_t max_width_;
+
+  std::vector<std::uint32_t> ids_;
+  std::vector<std::string_view> labels_;
+
+  std::size_t hash(std::string_view label) const {
+    if (label.empty() || label.size() > max_width_) std::abort();
+
+    std::size_t h = 0;
+    for (char c : label) {
+      const std::uint8_t digit = digits_[static_cast<unsigned char>(c)];
+      if (digit == 0) std::abort();
+      h = h * radix_ + digit;
+    }
+    return h;
+  }
+};
+
+}
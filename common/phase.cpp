@@ -0,0 +1,143 @@
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <unistd.h>
+
+#include "phase.h"
+
+namespace {
+
+// Relaxed atomics so that the counts stay right once solvers go multithreaded. It's only
+// bookkeeping so nothing needs ordering against it.
+std::atomic<std::uint64_t> alloc_count{0};
+std::atomic<std::uint64_t> alloc_bytes{0};
+
+thread_local std::uint64_t thread_alloc_count = 0;
+thread_local std::uint64_t thread_alloc_bytes = 0;
+
+void* counted_alloc(std::size_t size, std::size_t alignment) {
+  alloc_count.fetch_add(1, std::memory_order_relaxed);
+  alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+  ++thread_alloc_count;
+  thread_alloc_bytes += size;
+
+  // Zero byte allocations must still hand back a unique pointer.
+  if (size == 0) size = 1;
+
+  if (alignment <= alignof(std::max_align_t)) return std::malloc(size);
+
+  // aligned_alloc wants the size to be a multiple of the alignment.
+  return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+void* counted_alloc_or_throw(std::size_t size, std::size_t alignment) {
+  void* p = counted_alloc(size, alignment);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+int env_fd(const char* var) {
+  const char* env = std::getenv(var);
+  return env ? std::atoi(env) : -1;
+}
+
+int open_json_report() {
+  const char* path = std::getenv("AOC_PHASE_JSON");
+  if (!path) return -1;
+  if (std::strcmp(path, "-") == 0) return STDERR_FILENO;
+
+  const int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (fd < 0) {
+    std::perror(path);
+    std::exit(EXIT_FAILURE);
+  }
+
+  return fd;
+}
+
+}
+
+void* operator new(std::size_t size) { return counted_alloc_or_throw(size, 0); }
+void* operator new[](std::size_t size) { return counted_alloc_or_throw(size, 0); }
+void* operator new(std::size_t size, std::align_val_t al) {
+  return counted_alloc_or_throw(size, static_cast<std::size_t>(al));
+}
+void* operator new[](std::size_t size, std::align_val_t al) {
+  return counted_alloc_or_throw(size, static_cast<std::size_t>(al));
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size, 0); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size, 0); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+namespace aoc {
+
+AllocStats alloc_stats() {
+  return AllocStats{
+    alloc_count.load(std::memory_order_relaxed),
+    alloc_bytes.load(std::memory_order_relaxed)
+  };
+}
+
+AllocStats thread_alloc_stats() {
+  return AllocStats{thread_alloc_count, thread_alloc_bytes};
+}
+
+int json_report_fd() {
+  static const int fd = open_json_report();
+  return fd;
+}
+
+void write_report(int fd, const char* buf, int len) {
+  if (len < 0) std::abort();
+  while (len > 0) {
+    const ssize_t n = write(fd, buf, len);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) std::abort();
+    buf += n;
+    len -= n;
+  }
+}
+
+void report_phase(const char* name, const PhaseStats& stats) {
+  static const int fd = env_fd("AOC_PHASE_FD");
+  const int json = json_report_fd();
+
+  char buf[512];
+  if (fd >= 0) {
+    const int len = std::snprintf(buf, sizeof(buf), "%s %lld %lld %llu %llu %ld\n",
+      name, static_cast<long long>(stats.wall_ns), static_cast<long long>(stats.cpu_ns),
+      static_cast<unsigned long long>(stats.allocs), static_cast<unsigned long long>(stats.alloc_bytes),
+      stats.peak_rss_kb);
+    write_report(fd, buf, len);
+  }
+
+  if (json >= 0) {
+    // One object per line. The solver name comes from the executable so that several
+    // solvers can share a file.
+    const int len = std::snprintf(buf, sizeof(buf),
+      "{\"solver\":\"%s\",\"phase\":\"%s\",\"wall_ns\":%lld,\"cpu_ns\":%lld,"
+      "\"allocs\":%llu,\"alloc_bytes\":%llu,\"peak_rss_kb\":%ld}\n",
+      program_invocation_short_name, name,
+      static_cast<long long>(stats.wall_ns), static_cast<long long>(stats.cpu_ns),
+      static_cast<unsigned long long>(stats.allocs), static_cast<unsigned long long>(stats.alloc_bytes),
+      stats.peak_rss_kb);
+    write_report(json, buf, len);
+  }
+}
+
+}
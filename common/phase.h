@@ -0,0 +1,135 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <sys/resource.h>
+
+namespace aoc {
+
+// Heap allocation totals since the process started, counted by the operator new hook in
+// phase.cpp.
+struct AllocStats {
+  std::uint64_t count;
+  std::uint64_t bytes;
+};
+
+AllocStats alloc_stats();
+
+// The same, but only for allocations made by the calling thread.
+AllocStats thread_alloc_stats();
+
+// What a PhaseTimer counts CPU time and allocations for.
+enum class PhaseScope {
+  // The whole process. Right for phases that have the process to themselves, whether or
+  // not they fork work onto the pool.
+  Process,
+  // Just the calling thread. For phases that run alongside others on the pool (such as two
+  // parts started with parallel_invoke), whose process wide figures would include each
+  // other's work. Only right if the phase doesn't fork work of its own.
+  Thread,
+};
+
+// What a phase cost. Peak RSS is the process high-water mark when the phase finished (the
+// kernel doesn't offer anything finer), so it only goes up from phase to phase.
+struct PhaseStats {
+  std::int64_t wall_ns;
+  std::int64_t cpu_ns;
+  std::uint64_t allocs;
+  std::uint64_t alloc_bytes;
+  long peak_rss_kb;
+};
+
+// Hands a finished phase to whoever is listening (see phase.cpp). A no-op unless one of
+// AOC_PHASE_FD or AOC_PHASE_JSON is set.
+void report_phase(const char* name, const PhaseStats& stats);
+
+// The file named by AOC_PHASE_JSON, or -1 if JSON output isn't wanted. Anything else
+// reporting per-region stats (see counters.h) appends its lines here too.
+int json_report_fd();
+
+// Writes all of `buf` to `fd`, aborting on failure.
+void write_report(int fd, const char* buf, int len);
+
+// Times the consecutive phases of a solver (e.g. "parse", "P1", "P2"). Phase names mustn't
+// contain whitespace.
+//
+// Each phase records wall time, CPU time, heap allocations and peak RSS, with CPU time and
+// allocations counted for the process or just the calling thread (see PhaseScope). When a
+// phase finishes it's reported:
+// * on the file descriptor named by AOC_PHASE_FD as
+//   "<name> <wall ns> <cpu ns> <allocs> <alloc bytes> <peak rss kB>\n". The bench runner
+//   uses this to collect phase stats from the solver processes it spawns.
+// * as a line of JSON appended to the file named by AOC_PHASE_JSON ("-" for stderr).
+//
+// A second timer running alongside the top level one can break a phase down further. By
+// convention its phases are named after their parent, e.g. "P2/longest_path".
+//
+// Phases running side by side that can't use PhaseScope::Thread (because they fork work
+// themselves) report process wide CPU time and allocations, which include whatever else
+// was running at the time.
+class PhaseTimer {
+public:
+  explicit PhaseTimer(const char* name, PhaseScope scope = PhaseScope::Process)
+    : scope_(scope) { start(name); }
+
+  PhaseTimer(const PhaseTimer&) = delete;
+  PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+  ~PhaseTimer() { stop(); }
+
+  // Finish the current phase and start timing the next one.
+  void next(const char* name) {
+    stop();
+    start(name);
+  }
+
+  void stop() {
+    if (!name_) return;
+
+    const auto wall = std::chrono::steady_clock::now() - wall_start_;
+    const auto allocs = current_alloc_stats();
+
+    PhaseStats stats;
+    stats.wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wall).count();
+    stats.cpu_ns = cpu_now() - cpu_start_;
+    stats.allocs = allocs.count - allocs_start_.count;
+    stats.alloc_bytes = allocs.bytes - allocs_start_.bytes;
+    stats.peak_rss_kb = peak_rss_kb();
+
+    report_phase(name_, stats);
+    name_ = nullptr;
+  }
+
+private:
+  const char* name_;
+  PhaseScope scope_;
+  std::chrono::steady_clock::time_point wall_start_;
+  std::int64_t cpu_start_;
+  AllocStats allocs_start_;
+
+  void start(const char* name) {
+    name_ = name;
+    allocs_start_ = current_alloc_stats();
+    cpu_start_ = cpu_now();
+    wall_start_ = std::chrono::steady_clock::now();
+  }
+
+  AllocStats current_alloc_stats() const {
+    return scope_ == PhaseScope::Thread ? thread_alloc_stats() : alloc_stats();
+  }
+
+  std::int64_t cpu_now() const {
+    timespec ts;
+    clock_gettime(scope_ == PhaseScope::Thread ? CLOCK_THREAD_CPUTIME_ID : CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+  }
+
+  static long peak_rss_kb() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+  }
+};
+
+}
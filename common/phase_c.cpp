@@ -0,0 +1,20 @@
+#include "phase.h"
+#include "phase_c.h"
+
+struct aoc_phase_timer {
+  explicit aoc_phase_timer(const char* name) : timer(name) {}
+
+  aoc::PhaseTimer timer;
+};
+
+aoc_phase_timer* aoc_phase_start(const char* name) {
+  return new aoc_phase_timer(name);
+}
+
+void aoc_phase_next(aoc_phase_timer* timer, const char* name) {
+  timer->timer.next(name);
+}
+
+void aoc_phase_stop(aoc_phase_timer* timer) {
+  delete timer;
+}
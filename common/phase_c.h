@@ -0,0 +1,26 @@
+#pragma once
+
+// PhaseTimer (see phase.h) for the solvers written in C. Phases are reported the same way,
+// through AOC_PHASE_FD and AOC_PHASE_JSON.
+//
+// Allocations are only counted through operator new, so phases of C code that uses malloc
+// report none.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct aoc_phase_timer aoc_phase_timer;
+
+// Starts timing the first phase, with CPU time counted for the whole process.
+aoc_phase_timer* aoc_phase_start(const char* name);
+
+// Finishes the current phase and starts timing the next one.
+void aoc_phase_next(aoc_phase_timer* timer, const char* name);
+
+// Finishes the current phase and frees the timer.
+void aoc_phase_stop(aoc_phase_timer* timer);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace aoc {
+
+namespace detail {
+
+constexpr std::uint64_t broadcast(std::uint8_t b) { return 0x0101010101010101ULL * b; }
+
+// Number of leading decimal digits in an 8 byte little endian chunk.
+inline int count_digits(std::uint64_t chunk) {
+  // A byte has its top bit set in here unless it's in '0'..'9'.
+  const std::uint64_t non_digits =
+    ((chunk + broadcast(0x7f - '9')) | (chunk - broadcast('0'))) & broadcast(0x80);
+  return non_digits ? __builtin_ctzll(non_digits) / 8 : 8;
+}
+
+// Value of the first `len` (1 to 8) digits of a chunk, combining pairs of digits, then
+// pairs of pairs and so on, so it's three multiplies rather than eight.
+inline std::uint64_t digits_value(std::uint64_t chunk, int len) {
+  // Shift the digits up to the top so the unused low bytes act as leading zeros.
+  chunk = (chunk - broadcast('0')) << (8 * (8 - len));
+  chunk = (chunk * 10 + (chunk >> 8)) & 0x00ff00ff00ff00ffULL;
+  chunk = (chunk * 100 + (chunk >> 16)) & 0x0000ffff0000ffffULL;
+  return (chunk * 10000 + (chunk >> 32)) & 0xffffffffULL;
+}
+
+constexpr std::uint64_t pow10[9] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+
+}
+
+// Pulls numbers straight out of text, skipping whatever separates them (spaces, commas,
+// "~", "@", labels, ...). Anything that isn't a digit (or a '-' directly in front of one,
+// for signed types) is a separator.
+//
+// Integers are parsed eight digits at a time (SWAR) whenever there are eight bytes left
+// to read, so the scanner never reads past the end of the text. Floating point goes
+// through std::from_chars.
+class NumberScanner {
+public:
+  explicit NumberScanner(std::string_view text)
+    : pos_(text.data()), end_(text.data() + text.size()) {}
+
+  // Parse the next number into `value`. False (leaving `value` alone) if there are none
+  // left.
+  template<typename T>
+  bool next(T& value) {
+    if constexpr (std::is_floating_point_v<T>) {
+      if (!skip_to_number(true)) return false;
+      pos_ = std::from_chars(pos_, end_, value).ptr;
+      return true;
+    }
+    else {
+      if (!skip_to_number(std::is_signed_v<T>)) return false;
+
+      const bool negative = *pos_ == '-';
+      pos_ += negative;
+
+      std::uint64_t v = 0;
+      while (true) {
+        int len;
+        if (end_ - pos_ >= 8) {
+          std::uint64_t chunk;
+          std::memcpy(&chunk, pos_, 8);
+          len = detail::count_digits(chunk);
+          if (len > 0) v = v * detail::pow10[len] + detail::digits_value(chunk, len);
+        }
+        else {
+          len = 0;
+          while (pos_ + len < end_ && is_digit(pos_[len])) {
+            v = 10 * v + (pos_[len] - '0');
+            ++len;
+          }
+        }
+
+        pos_ += len;
+        if (len < 8) break;
+      }
+
+      value = negative ? static_cast<T>(-static_cast<std::int64_t>(v)) : static_cast<T>(v);
+      return true;
+    }
+  }
+
+  // The next number, which must be there.
+  template<typename T>
+  T next() {
+    T value;
+    if (!next(value)) std::abort();
+    return value;
+  }
+
+  // Whatever hasn't been scanned yet.
+  std::string_view rest() const { return std::string_view(pos_, end_ - pos_); }
+
+private:
+  const char* pos_;
+  const char* end_;
+
+  static bool is_digit(char c) { return static_cast<unsigned char>(c - '0') < 10; }
+
+  bool skip_to_number(bool allow_sign) {
+    while (pos_ < end_) {
+      if (is_digit(*pos_)) return true;
+      if (allow_sign && *pos_ == '-' && pos_ + 1 < end_ && is_digit(pos_[1])) return true;
+      ++pos_;
+    }
+    return false;
+  }
+};
+
+// Scans every number in `text` into columns, struct of arrays style: the first number goes
+// in the first column, the second in the second and so on, wrapping around. So for lines
+// like "1,0,1~1,2,1" six columns get one entry per line. Returns the number of complete
+// rows (a trailing partial row is dropped).
+template<typename... Columns>
+std::size_t scan_columns(std::string_view text, std::vector<Columns>&... columns) {
+  NumberScanner scanner(text);
+  std::size_t rows = 0;
+  while (true) {
+    bool complete = true;
+    ((complete = complete && scanner.next(columns.emplace_back())), ...);
+    if (!complete) {
+      // Drop whatever made it into the row we were part way through.
+      ((columns.size() > rows ? columns.pop_back() : void()), ...);
+      return rows;
+    }
+    ++rows;
+  }
+}
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string_view>
+
+#include "input.h"
+
+namespace aoc {
+
+// Every C++ day exposes its solution as `Answer dN::solve(std::string_view input)`, which
+// doesn't touch any global state or print anything, so it can be called repeatedly (and
+// concurrently) in process. Days compiled with AOC_LIBRARY leave out their main() and go
+// into the dN_lib static library.
+struct Answer {
+  // Either part can be missing: not every day has a part 2 solution, and some answers don't
+  // fit in 64 bits for every input.
+  std::optional<std::int64_t> p1;
+  std::optional<std::int64_t> p2;
+};
+
+using SolveFn = Answer (*)(std::string_view);
+
+// The standalone main(): solve the file named on the command line (input.txt by default).
+inline int solver_main(int argc, char** argv, SolveFn solve) {
+  Input input(argc > 1 ? argv[1] : "input.txt");
+  const Answer answer = solve(input.data());
+
+  std::cout << "P1: ";
+  if (answer.p1) std::cout << *answer.p1;
+  else std::cout << "-";
+  if (answer.p2) std::cout << ", P2: " << *answer.p2;
+  std::cout << "\n";
+
+  return EXIT_SUCCESS;
+}
+
+}
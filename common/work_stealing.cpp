@@ -0,0 +1,250 @@
+#include <algorithm>
+
+#include "work_stealing.h"
+
+namespace aoc {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::int64_t since(Clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+// Work and span of the task running on this thread so far. Time is accumulated in
+// segments: a segment ends whenever the task forks, and the children's work and span are
+// folded in when they join.
+struct TaskClock {
+  std::int64_t work_ns = 0;
+  std::int64_t span_ns = 0;
+  Clock::time_point segment_start = Clock::now();
+
+  void end_segment() {
+    const auto ns = since(segment_start);
+    work_ns += ns;
+    span_ns += ns;
+  }
+};
+
+thread_local WorkStealingPool* this_pool = nullptr;
+thread_local std::size_t this_worker = 0;
+thread_local TaskClock* this_task = nullptr;
+
+// How many tasks deep this worker is (tasks run while helping at a join nest).
+thread_local int run_depth = 0;
+
+WorkStealingPool::JobStats timed(const std::function<void()>& f) {
+  TaskClock clock;
+  TaskClock* parent = this_task;
+  this_task = &clock;
+  f();
+  clock.end_segment();
+  this_task = parent;
+  return WorkStealingPool::JobStats{clock.work_ns, clock.span_ns};
+}
+
+}
+
+WorkStealingPool::WorkStealingPool(std::size_t num_threads) {
+  if (num_threads == 0) num_threads = 1;
+  for (std::size_t i = 0; i < num_threads; i++) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+
+  // Only start the threads once every deque exists, since they steal from each other.
+  for (std::size_t i = 0; i < num_threads; i++) {
+    workers_[i]->thread = std::thread([this, i] { run(i); });
+  }
+}
+
+void WorkStealingPool::join() {
+  wait();
+  stopping_ = true;
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    sleep_cv_.notify_all();
+  }
+  for (auto& w : workers_) {
+    if (w->thread.joinable()) w->thread.join();
+  }
+}
+
+WorkStealingPool* WorkStealingPool::current() {
+  return this_pool;
+}
+
+void WorkStealingPool::submit(std::function<void()> job, std::function<void(const JobStats&)> done) {
+  {
+    std::lock_guard<std::mutex> lock(outstanding_mutex_);
+    ++outstanding_;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(injected_mutex_);
+    injected_.push_back([this, job = std::move(job), done = std::move(done)] {
+      const JobStats stats = timed(job);
+      if (done) done(stats);
+
+      std::lock_guard<std::mutex> lock(outstanding_mutex_);
+      if (--outstanding_ == 0) outstanding_cv_.notify_all();
+    });
+  }
+
+  wake_one();
+}
+
+void WorkStealingPool::wait() {
+  std::unique_lock<std::mutex> lock(outstanding_mutex_);
+  outstanding_cv_.wait(lock, [this] { return outstanding_ == 0; });
+}
+
+std::vector<WorkStealingPool::WorkerStats> WorkStealingPool::worker_stats() const {
+  std::vector<WorkerStats> stats;
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  for (const auto& w : workers_) stats.push_back(w->stats);
+  return stats;
+}
+
+void WorkStealingPool::fork_join(std::vector<std::function<void()>>& tasks) {
+  if (tasks.empty()) return;
+
+  // Close off the parent's work so far: from here on it's the children's time that counts.
+  TaskClock* parent = this_task;
+  parent->end_segment();
+
+  std::vector<JobStats> child_stats(tasks.size());
+  std::atomic<std::size_t> remaining{tasks.size() - 1};
+
+  // Everything but the first task goes on our own deque for anyone to take, then we get
+  // on with the first one ourselves.
+  Worker& self = *workers_[this_worker];
+  {
+    std::lock_guard<std::mutex> lock(self.mutex);
+    for (std::size_t i = tasks.size() - 1; i > 0; i--) {
+      self.tasks.push_back([&tasks, &child_stats, &remaining, i] {
+        child_stats[i] = timed(tasks[i]);
+        remaining.fetch_sub(1, std::memory_order_release);
+      });
+    }
+  }
+  for (std::size_t i = 1; i < tasks.size() && num_sleeping_ > 0; i++) wake_one();
+
+  child_stats[0] = timed(tasks[0]);
+
+  // Help out until the rest are done. Our own deque comes first, which (being LIFO) gets
+  // through our own children before anything else. Fresh jobs are left alone: starting a
+  // whole new job here would hold up this one until it finished.
+  std::int64_t idle_ns = 0;
+  while (remaining.load(std::memory_order_acquire) > 0) {
+    Task task;
+    if (find_task(this_worker, task, false)) {
+      run_task(this_worker, task);
+      continue;
+    }
+
+    const auto start = Clock::now();
+    std::this_thread::yield();
+    idle_ns += since(start);
+  }
+
+  if (idle_ns > 0) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    self.stats.idle_ns += idle_ns;
+    self.stats.busy_ns -= idle_ns;
+  }
+
+  for (const auto& s : child_stats) parent->work_ns += s.work_ns;
+  parent->span_ns += std::max_element(child_stats.begin(), child_stats.end(),
+    [] (const JobStats& a, const JobStats& b) { return a.span_ns < b.span_ns; })->span_ns;
+  parent->segment_start = Clock::now();
+}
+
+void WorkStealingPool::run(std::size_t index) {
+  this_pool = this;
+  this_worker = index;
+
+  while (true) {
+    const auto idle_start = Clock::now();
+    Task task;
+    while (!find_task(index, task, true)) {
+      if (stopping_) {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        workers_[index]->stats.idle_ns += since(idle_start);
+        return;
+      }
+
+      // New work pushes wake a sleeper, but don't sleep long in case a wake up got missed.
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      ++num_sleeping_;
+      sleep_cv_.wait_for(lock, std::chrono::milliseconds(1));
+      --num_sleeping_;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(stats_mutex_);
+      workers_[index]->stats.idle_ns += since(idle_start);
+    }
+
+    run_task(index, task);
+  }
+}
+
+bool WorkStealingPool::find_task(std::size_t index, Task& task, bool take_jobs) {
+  Worker& self = *workers_[index];
+  {
+    std::lock_guard<std::mutex> lock(self.mutex);
+    if (!self.tasks.empty()) {
+      task = std::move(self.tasks.back());
+      self.tasks.pop_back();
+      return true;
+    }
+  }
+
+  // Stealing forked work comes before starting new jobs: it's what's holding up the jobs
+  // already in flight.
+  for (std::size_t i = 1; i < workers_.size(); i++) {
+    Worker& victim = *workers_[(index + i) % workers_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+
+      std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+      ++self.stats.steals;
+      return true;
+    }
+  }
+
+  if (take_jobs) {
+    std::lock_guard<std::mutex> lock(injected_mutex_);
+    if (!injected_.empty()) {
+      task = std::move(injected_.front());
+      injected_.pop_front();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void WorkStealingPool::run_task(std::size_t index, Task& task) {
+  const auto start = Clock::now();
+  ++run_depth;
+  task();
+  --run_depth;
+
+  // Busy time is only counted for the outermost task, which covers anything run while it
+  // was helping at a join. Time spent idle at those joins has already been taken off.
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  if (run_depth == 0) workers_[index]->stats.busy_ns += since(start);
+  ++workers_[index]->stats.tasks_run;
+}
+
+void WorkStealingPool::wake_one() {
+  if (num_sleeping_ == 0) return;
+  std::lock_guard<std::mutex> lock(sleep_mutex_);
+  sleep_cv_.notify_one();
+}
+
+}
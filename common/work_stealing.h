@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aoc {
+
+// A thread pool where every worker has its own deque of tasks. Workers push and pop their
+// own tasks at the back (so nested forks run depth first and stay cache warm) and, when
+// they run dry, steal from the front of somebody else's deque.
+//
+// Solvers don't use the pool directly: they call parallel_invoke / parallel_for below,
+// which fork onto the pool when called from one of its tasks and otherwise just run
+// everything in order on the calling thread. So the standalone solvers behave exactly as
+// before.
+//
+// The pool also measures itself:
+// * per worker busy and idle time (idle being any time spent with nothing to run, whether
+//   waiting for new work or waiting at a join with nothing to steal).
+// * for each submitted job its total work and its critical path (span): the longest chain
+//   of work that had to happen one piece after another. work / span is how much
+//   parallelism the job exposes.
+class WorkStealingPool {
+public:
+  struct WorkerStats {
+    std::int64_t busy_ns = 0;
+    std::int64_t idle_ns = 0;
+    std::uint64_t tasks_run = 0;
+    std::uint64_t steals = 0;
+  };
+
+  struct JobStats {
+    std::int64_t work_ns = 0;
+    std::int64_t span_ns = 0;
+  };
+
+  explicit WorkStealingPool(std::size_t num_threads);
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  // Finishes everything already submitted before joining the workers.
+  ~WorkStealingPool() { join(); }
+
+  // Queue up a job from outside the pool. `done` (if given) is called on the worker when
+  // the job and everything it forked has finished.
+  void submit(std::function<void()> job, std::function<void(const JobStats&)> done = {});
+
+  // Blocks until every submitted job has finished.
+  void wait();
+
+  // Waits for every submitted job and then shuts the workers down, after which their stats
+  // are final. Nothing can be submitted afterwards.
+  void join();
+
+  std::size_t size() const { return workers_.size(); }
+
+  // Snapshot of the per worker stats so far.
+  std::vector<WorkerStats> worker_stats() const;
+
+  // Used by parallel_invoke: pushes forked tasks onto the calling worker's deque and works
+  // (or steals) until they're all done. Only valid on a worker thread.
+  void fork_join(std::vector<std::function<void()>>& tasks);
+
+  // The pool the calling thread is a worker of (nullptr outside any pool).
+  static WorkStealingPool* current();
+
+private:
+  using Task = std::function<void()>;
+
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+    WorkerStats stats;
+    std::thread thread;
+  };
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  // Jobs submitted from outside, picked up by whichever worker gets there first.
+  std::mutex injected_mutex_;
+  std::deque<Task> injected_;
+
+  // Sleeping workers wait on this when there's nothing anywhere to run.
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cv_;
+  std::atomic<int> num_sleeping_{0};
+  std::atomic<bool> stopping_{false};
+
+  std::mutex outstanding_mutex_;
+  std::condition_variable outstanding_cv_;
+  std::size_t outstanding_ = 0;
+
+  mutable std::mutex stats_mutex_;
+
+  void run(std::size_t index);
+  bool find_task(std::size_t index, Task& task, bool take_jobs);
+  void run_task(std::size_t index, Task& task);
+  void wake_one();
+};
+
+// Runs the functions, potentially in parallel, returning once they've all finished.
+template<typename... F>
+void parallel_invoke(F&&... fs) {
+  WorkStealingPool* pool = WorkStealingPool::current();
+  if (!pool) {
+    (fs(), ...);
+    return;
+  }
+
+  std::vector<std::function<void()>> tasks;
+  tasks.reserve(sizeof...(fs));
+  (tasks.emplace_back([&fs] { fs(); }), ...);
+  pool->fork_join(tasks);
+}
+
+// Calls f(i) for every i in [0, n), potentially in parallel.
+template<typename F>
+void parallel_for(std::size_t n, F&& f) {
+  WorkStealingPool* pool = WorkStealingPool::current();
+  if (!pool) {
+    for (std::size_t i = 0; i < n; i++) f(i);
+    return;
+  }
+
+  std::vector<std::function<void()>> tasks;
+  tasks.reserve(n);
+  for (std::size_t i = 0; i < n; i++) tasks.emplace_back([&f, i] { f(i); });
+  pool->fork_join(tasks);
+}
+
+}
@@ -1,54 +1,315 @@
-#include "ctype.h"
+#include "fcntl.h"
+#include "pthread.h"
+#include "stdint.h"
 #include "stdio.h"
+#include "stdlib.h"
 #include "string.h"
+#include "sys/mman.h"
+#include "sys/stat.h"
+#include "unistd.h"
 
-const char* numbers[] =
+#if defined(__x86_64__)
+#include "immintrin.h"
+#endif
+
+#include "d1_dfa.h"
+#include "phase_c.h"
+
+// Part 1 only needs the first and last digit of each line, so rather than looking at the
+// lines a byte at a time the whole input goes through in 64 byte blocks. Each block is
+// boiled down to two bit masks (which bytes are digits, which are newlines) using 32 or 16
+// byte compares, and then every line costs a couple of ctz/clz whatever its length.
+
+// Bit i is set if block[i] is a digit / a newline.
+typedef struct
 {
-  "one", "two", "three", "four", "five", "six", "seven", "eight", "nine"
-};
+  uint64_t digits;
+  uint64_t newlines;
+} BlockMasks;
 
-int get_digit_p1(char* p)
+// The line currently being scanned (it can span any number of blocks) and the running sum.
+typedef struct
 {
-  if (isdigit(p[0])) return p[0] - '0';
-  return 0;
+  int first; // -1 until the line's first digit turns up
+  int last;
+  long total;
+} CalibrationState;
+
+static inline void end_line(CalibrationState* s)
+{
+  if (s->first >= 0) s->total += 10 * s->first + s->last;
+  s->first = -1;
+}
+
+static inline void consume_block(CalibrationState* s, const char* block, BlockMasks m)
+{
+  while (m.newlines)
+  {
+    const int end = __builtin_ctzll(m.newlines);
+    const uint64_t line_digits = m.digits & ((1ULL << end) - 1);
+    if (line_digits)
+    {
+      if (s->first < 0) s->first = block[__builtin_ctzll(line_digits)] - '0';
+      s->last = block[63 - __builtin_clzll(line_digits)] - '0';
+    }
+    end_line(s);
+
+    // Drop everything up to and including the newline.
+    const uint64_t rest = ~((2ULL << end) - 1);
+    m.digits &= rest;
+    m.newlines &= rest;
+  }
+
+  if (m.digits)
+  {
+    if (s->first < 0) s->first = block[__builtin_ctzll(m.digits)] - '0';
+    s->last = block[63 - __builtin_clzll(m.digits)] - '0';
+  }
+}
+
+// For the tail of the input, which is less than a whole block.
+static BlockMasks block_masks_scalar(const char* block, size_t len)
+{
+  BlockMasks m = {0, 0};
+  for (size_t i = 0; i < len; i++)
+  {
+    m.digits |= (uint64_t)((unsigned char)(block[i] - '0') < 10) << i;
+    m.newlines |= (uint64_t)(block[i] == '\n') << i;
+  }
+  return m;
+}
+
+#if defined(__x86_64__)
+
+// A byte is a digit if subtracting '0' leaves it no bigger than 9 (unsigned), i.e. if
+// min(b - '0', 9) is b - '0'.
+static inline BlockMasks block_masks_sse2(const char* block)
+{
+  const __m128i zero = _mm_set1_epi8('0');
+  const __m128i nine = _mm_set1_epi8(9);
+  const __m128i newline = _mm_set1_epi8('\n');
+
+  BlockMasks m = {0, 0};
+  for (int i = 0; i < 4; i++)
+  {
+    const __m128i bytes = _mm_loadu_si128((const __m128i*)(block + 16 * i));
+    const __m128i offset = _mm_sub_epi8(bytes, zero);
+    const __m128i digits = _mm_cmpeq_epi8(_mm_min_epu8(offset, nine), offset);
+    m.digits |= (uint64_t)(uint16_t)_mm_movemask_epi8(digits) << (16 * i);
+    m.newlines |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)) << (16 * i);
+  }
+  return m;
+}
+
+__attribute__((target("avx2")))
+static inline BlockMasks block_masks_avx2(const char* block)
+{
+  const __m256i zero = _mm256_set1_epi8('0');
+  const __m256i nine = _mm256_set1_epi8(9);
+  const __m256i newline = _mm256_set1_epi8('\n');
+
+  BlockMasks m = {0, 0};
+  for (int i = 0; i < 2; i++)
+  {
+    const __m256i bytes = _mm256_loadu_si256((const __m256i*)(block + 32 * i));
+    const __m256i offset = _mm256_sub_epi8(bytes, zero);
+    const __m256i digits = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, nine), offset);
+    m.digits |= (uint64_t)(uint32_t)_mm256_movemask_epi8(digits) << (32 * i);
+    m.newlines |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newline)) << (32 * i);
+  }
+  return m;
+}
+
+// Both return how much of the input they got through (all of the whole blocks).
+static size_t consume_blocks_sse2(CalibrationState* s, const char* buf, size_t len)
+{
+  size_t i = 0;
+  for (; i + 64 <= len; i += 64) consume_block(s, buf + i, block_masks_sse2(buf + i));
+  return i;
+}
+
+__attribute__((target("avx2")))
+static size_t consume_blocks_avx2(CalibrationState* s, const char* buf, size_t len)
+{
+  size_t i = 0;
+  for (; i + 64 <= len; i += 64) consume_block(s, buf + i, block_masks_avx2(buf + i));
+  return i;
 }
 
-int get_digit_p2(char* p)
+#endif
+
+// Sum of the part 1 calibration values of every line in buf.
+long sum_calibration_values_p1(const char* buf, size_t len)
 {
-  int p1 = get_digit_p1(p);
-  if (p1) return p1;
+  CalibrationState s = {-1, 0, 0};
 
-  for (int i = 0; i < 9; i++)
+  size_t i = 0;
+#if defined(__x86_64__)
+  if (__builtin_cpu_supports("avx2")) i = consume_blocks_avx2(&s, buf, len);
+  else i = consume_blocks_sse2(&s, buf, len);
+#endif
+
+  for (; i < len; i += 64)
   {
-    if (strncmp(p, numbers[i], strlen(numbers[i])) == 0) return i + 1;
+    const size_t block_len = len - i < 64 ? len - i : 64;
+    consume_block(&s, buf + i, block_masks_scalar(buf + i, block_len));
+  }
+
+  // The last line might not have a newline.
+  end_line(&s);
+
+  return s.total;
+}
+
+// Part 2 runs the automata from d1_dfa_gen.c over a line, one from each end, stopping at
+// the first digit (written either way) each of them finds. So every byte is looked at
+// once at most, with a table lookup rather than a strncmp per word.
+int first_digit_p2(const char* line, size_t len)
+{
+  uint8_t s = 0;
+  for (size_t i = 0; i < len; i++)
+  {
+    s = forward_dfa[s][byte_class[(unsigned char)line[i]]];
+    if (s >= forward_hit_state) return s - forward_hit_state;
+  }
+
+  return 0;
+}
+
+int last_digit_p2(const char* line, size_t len)
+{
+  uint8_t s = 0;
+  for (size_t i = len; i > 0; i--)
+  {
+    s = reverse_dfa[s][byte_class[(unsigned char)line[i - 1]]];
+    if (s >= reverse_hit_state) return s - reverse_hit_state;
   }
 
   return 0;
 }
 
-int main()
+// The input is mapped rather than read, so it can be far bigger than memory, and split
+// into one chunk per thread on line boundaries. Each thread works through its chunk a
+// slice at a time, doing both parts on a slice while it's still in cache, and the partial
+// sums are added up at the end.
+
+#define MAX_THREADS 64
+
+// Not worth starting a thread for less than this.
+#define MIN_CHUNK_SIZE (1 << 20)
+
+#define SLICE_SIZE (256 * 1024)
+
+typedef struct
+{
+  const char* begin;
+  const char* end;
+  long total[2];
+} Chunk;
+
+// Just past the end of the line that p is part of.
+const char* next_line(const char* p, const char* end)
+{
+  const char* newline = memchr(p, '\n', end - p);
+  return newline ? newline + 1 : end;
+}
+
+void* solve_chunk(void* arg)
 {
-  FILE* f = fopen("input.txt", "r");
-  char buf[100];
-  int total[2] = {0, 0};
-  while (fscanf(f, "%s\n", buf) != EOF)
+  Chunk* c = arg;
+  c->total[0] = c->total[1] = 0;
+
+  for (const char* slice = c->begin; slice < c->end;)
   {
-    int digits_p1[2] = {0, 0};
-    int digits_p2[2] = {0, 0};
-    size_t len = strlen(buf);
-    for (int i = 0; i < len; i++)
+    const char* slice_end = c->end - slice > SLICE_SIZE ? next_line(slice + SLICE_SIZE - 1, c->end) : c->end;
+
+    c->total[0] += sum_calibration_values_p1(slice, slice_end - slice);
+
+    for (const char* line = slice; line < slice_end;)
     {
-      if (!digits_p1[0]) digits_p1[0] = get_digit_p1(&buf[i]);
-      if (!digits_p2[0]) digits_p2[0] = get_digit_p2(&buf[i]);
-      if (!digits_p1[1]) digits_p1[1] = get_digit_p1(&buf[len - i - 1]);
-      if (!digits_p2[1]) digits_p2[1] = get_digit_p2(&buf[len - i - 1]);
+      const char* end = next_line(line, slice_end);
+      const size_t line_len = end - line - (end[-1] == '\n');
+      c->total[1] += 10 * first_digit_p2(line, line_len) + last_digit_p2(line, line_len);
+      line = end;
     }
 
-    total[0] += 10 * digits_p1[0] + digits_p1[1];
-    total[1] += 10 * digits_p2[0] + digits_p2[1];
+    slice = slice_end;
   }
 
-  printf("P1: %d, P2: %d\n", total[0], total[1]);
+  return NULL;
+}
+
+int main(int argc, char** argv)
+{
+  aoc_phase_timer* timer = aoc_phase_start("parse");
+
+  int fd = open(argc > 1 ? argv[1] : "input.txt", O_RDONLY);
+  if (fd < 0) return 1;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) return 1;
+
+  const size_t len = st.st_size;
+  const char* buf = NULL;
+  if (len > 0)
+  {
+    buf = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (buf == MAP_FAILED) return 1;
+    madvise((void*)buf, len, MADV_SEQUENTIAL);
+  }
+
+  // One thread per CPU, as long as they each get a decent sized chunk.
+  long num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  if (num_threads > (long)(len / MIN_CHUNK_SIZE)) num_threads = len / MIN_CHUNK_SIZE;
+  if (num_threads > MAX_THREADS) num_threads = MAX_THREADS;
+  if (num_threads < 1) num_threads = 1;
+
+  Chunk chunks[MAX_THREADS];
+  const char* begin = buf;
+  for (long i = 0; i < num_threads; i++)
+  {
+    const char* end = buf + len;
+    if (i + 1 < num_threads)
+    {
+      const char* split = buf + (i + 1) * (len / num_threads);
+      end = split > begin ? next_line(split - 1, buf + len) : begin;
+    }
+
+    chunks[i].begin = begin;
+    chunks[i].end = end;
+    begin = end;
+  }
+
+  // Both parts go through a slice together (see above), so they're timed as one phase.
+  aoc_phase_next(timer, "P1+P2");
+
+  // The calling thread takes the first chunk itself, along with any that a thread couldn't
+  // be started for.
+  pthread_t threads[MAX_THREADS];
+  int started[MAX_THREADS] = {0};
+  for (long i = 1; i < num_threads; i++)
+  {
+    started[i] = pthread_create(&threads[i], NULL, solve_chunk, &chunks[i]) == 0;
+  }
+  solve_chunk(&chunks[0]);
+  for (long i = 1; i < num_threads; i++)
+  {
+    if (!started[i]) solve_chunk(&chunks[i]);
+  }
+
+  long total[2] = {chunks[0].total[0], chunks[0].total[1]};
+  for (long i = 1; i < num_threads; i++)
+  {
+    if (started[i]) pthread_join(threads[i], NULL);
+    total[0] += chunks[i].total[0];
+    total[1] += chunks[i].total[1];
+  }
+  aoc_phase_stop(timer);
+
+  printf("P1: %ld, P2: %ld\n", total[0], total[1]);
+
+  if (buf) munmap((void*)buf, len);
+  close(fd);
 
   return 0;
 }
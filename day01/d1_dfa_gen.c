@@ -0,0 +1,183 @@
+#include "stdio.h"
+#include "string.h"
+
+// Builds the automata part 2 uses to find digits ("7" or "seven") and writes them out as a
+// header of C tables. Run by the build (see CMakeLists.txt) as "d1_dfa_gen <header>".
+//
+// Each automaton is an Aho-Corasick matcher over all of the digit patterns, flattened into
+// a DFA: from any state there's exactly one transition per input byte and no failure links
+// to chase at runtime. The forward one is built from the words as written and the reverse
+// one from the words backwards, for scanning a line from its end.
+//
+// As the scans stop at the first digit found, accepting states don't need transitions of
+// their own. Every transition into one goes to a "hit" state instead: hit_state + the digit.
+// No digit word has another inside it, so the first word to finish is also the first to
+// start, which is the one we're after.
+//
+// Bytes are mapped to classes first (one per character that appears in any pattern, plus
+// one for everything else) so the tables stay small enough to sit in L1.
+
+#define MAX_STATES 64
+#define NUM_BYTES 256
+
+const char* words[] =
+{
+  "one", "two", "three", "four", "five", "six", "seven", "eight", "nine"
+};
+
+int byte_class[NUM_BYTES];
+int num_classes = 1; // Class 0 is everything that doesn't appear in a pattern.
+
+typedef struct
+{
+  int next[NUM_BYTES]; // Trie edges to begin with (-1 for none), then DFA transitions.
+  int fail;
+  int digit; // Digit matched on reaching this state, -1 for none.
+} State;
+
+typedef struct
+{
+  State states[MAX_STATES];
+  int num_states;
+} Automaton;
+
+int add_state(Automaton* a)
+{
+  State* s = &a->states[a->num_states];
+  for (int c = 0; c < NUM_BYTES; c++) s->next[c] = -1;
+  s->fail = 0;
+  s->digit = -1;
+  return a->num_states++;
+}
+
+void add_pattern(Automaton* a, const char* pattern, int reverse, int digit)
+{
+  int s = 0;
+  int len = strlen(pattern);
+  for (int i = 0; i < len; i++)
+  {
+    unsigned char c = pattern[reverse ? len - i - 1 : i];
+    if (a->states[s].next[c] < 0)
+    {
+      int t = add_state(a);
+      a->states[s].next[c] = t;
+    }
+    s = a->states[s].next[c];
+  }
+
+  a->states[s].digit = digit;
+}
+
+void build(Automaton* a, int reverse)
+{
+  a->num_states = 0;
+  add_state(a);
+
+  for (int d = 0; d < 10; d++)
+  {
+    char digit[2] = {'0' + d, '\0'};
+    add_pattern(a, digit, reverse, d);
+    if (d > 0) add_pattern(a, words[d - 1], reverse, d);
+  }
+
+  // Breadth first, so a state's failure state is always finished before the state itself.
+  int queue[MAX_STATES];
+  int head = 0, tail = 0;
+
+  for (int c = 0; c < NUM_BYTES; c++)
+  {
+    int t = a->states[0].next[c];
+    if (t < 0)
+    {
+      a->states[0].next[c] = 0;
+    }
+    else
+    {
+      a->states[t].fail = 0;
+      queue[tail++] = t;
+    }
+  }
+
+  while (head < tail)
+  {
+    State* s = &a->states[queue[head++]];
+    if (s->digit < 0) s->digit = a->states[s->fail].digit;
+
+    for (int c = 0; c < NUM_BYTES; c++)
+    {
+      int t = s->next[c];
+      if (t < 0)
+      {
+        s->next[c] = a->states[s->fail].next[c];
+      }
+      else
+      {
+        a->states[t].fail = a->states[s->fail].next[c];
+        queue[tail++] = t;
+      }
+    }
+  }
+}
+
+void write_table(const Automaton* a, const char* name)
+{
+  // Renumber so the accepting states drop out and the hits follow straight on.
+  int index[MAX_STATES];
+  int num_kept = 0;
+  for (int s = 0; s < a->num_states; s++)
+  {
+    index[s] = a->states[s].digit < 0 ? num_kept++ : -1;
+  }
+
+  // One representative byte per class.
+  int class_byte[NUM_BYTES];
+  for (int c = NUM_BYTES - 1; c >= 0; c--) class_byte[byte_class[c]] = c;
+
+  printf("\n#define %s_hit_state %d\n\n", name, num_kept);
+  printf("static const uint8_t %s_dfa[%d][%d] =\n{\n", name, num_kept, num_classes);
+  for (int s = 0; s < a->num_states; s++)
+  {
+    if (index[s] < 0) continue;
+
+    printf("  {");
+    for (int k = 0; k < num_classes; k++)
+    {
+      const State* t = &a->states[a->states[s].next[class_byte[k]]];
+      int next = t->digit < 0 ? index[t - a->states] : num_kept + t->digit;
+      printf("%s%d", k ? ", " : "", next);
+    }
+    printf("},\n");
+  }
+  printf("};\n");
+}
+
+int main(int argc, char** argv)
+{
+  if (argc != 2 || !freopen(argv[1], "w", stdout)) return 1;
+
+  for (int d = 0; d < 10; d++) byte_class['0' + d] = num_classes++;
+  for (int w = 0; w < 9; w++)
+  {
+    for (const char* c = words[w]; *c; c++)
+    {
+      if (!byte_class[(unsigned char)*c]) byte_class[(unsigned char)*c] = num_classes++;
+    }
+  }
+
+  printf("// Generated by d1_dfa_gen.c.\n\n");
+  printf("#include \"stdint.h\"\n\n");
+  printf("static const uint8_t byte_class[%d] =\n{", NUM_BYTES);
+  for (int c = 0; c < NUM_BYTES; c++)
+  {
+    printf("%s%d", c % 16 ? ", " : (c ? ",\n  " : "\n  "), byte_class[c]);
+  }
+  printf("\n};\n");
+
+  static Automaton a;
+  build(&a, 0);
+  write_table(&a, "forward");
+  build(&a, 1);
+  write_table(&a, "reverse");
+
+  return 0;
+}
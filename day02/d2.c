@@ -1,91 +1,532 @@
-#include "ctype.h"
+#include "stdint.h"
 #include "stdio.h"
+#include "stdlib.h"
 #include "string.h"
 
+#if defined(__x86_64__)
+#include "immintrin.h"
+#endif
+
+#include "phase_c.h"
+
 #define MAX(x, y) (x > y ? x : y)
 
-int main()
+enum colour
+{
+  RED,
+  GREEN,
+  BLUE,
+  NUM_COLOURS
+};
+
+// The per game maximum of each colour, a column per colour.
+typedef struct
+{
+  size_t num_games;
+  size_t capacity;
+  uint32_t* id;
+  uint16_t* max[NUM_COLOURS];
+} GameLog;
+
+void add_game(GameLog* log, uint32_t id)
+{
+  if (log->num_games == log->capacity)
+  {
+    log->capacity = log->capacity ? 2 * log->capacity : 256;
+    log->id = realloc(log->id, log->capacity * sizeof(uint32_t));
+    for (int c = 0; c < NUM_COLOURS; c++)
+    {
+      log->max[c] = realloc(log->max[c], log->capacity * sizeof(uint16_t));
+    }
+  }
+
+  log->id[log->num_games] = id;
+  for (int c = 0; c < NUM_COLOURS; c++) log->max[c][log->num_games] = 0;
+  ++log->num_games;
+}
+
+void free_games(GameLog* log)
+{
+  free(log->id);
+  for (int c = 0; c < NUM_COLOURS; c++) free(log->max[c]);
+}
+
+static int is_digit(char c)
+{
+  return (unsigned char)(c - '0') < 10;
+}
+
+// Parsing the input is rather awkward (at least, it is in C). It used to be a byte at a
+// time state machine, but every draw is "<number> <colour>" followed by ", ", "; " or the
+// end of the line, so once the number's been read the first letter of the colour says
+// which column to update and how far to jump to the next draw. The colour's name is checked
+// as a whole word and the only loop is over the digits. (This is still scalar code: each
+// draw's length depends on the last, which doesn't leave much for SIMD to do.)
+//
+// Lines can end in "\r\n". Anything else that doesn't fit is reported and stops the parse.
+__attribute__((noreturn, cold))
+static void bad_record(const char* buf, const char* p)
+{
+  fprintf(stderr, "Bad game record at byte %zu\n", (size_t)(p - buf));
+  exit(EXIT_FAILURE);
+}
+
+GameLog parse_games(const char* buf, size_t len)
+{
+  static const char* const colour_name[NUM_COLOURS] = {"red", "green", "blue"};
+  static const uint8_t colour_length[NUM_COLOURS] = {3, 5, 4};
+  int8_t colour_index[256];
+  memset(colour_index, -1, sizeof(colour_index));
+  colour_index['r'] = RED;
+  colour_index['g'] = GREEN;
+  colour_index['b'] = BLUE;
+
+  // Away from the end of the input a name can be checked with one 8 byte load, masked down
+  // to its length.
+  uint64_t colour_word[NUM_COLOURS] = {0}, colour_mask[NUM_COLOURS] = {0};
+  for (int c = 0; c < NUM_COLOURS; c++)
+  {
+    memcpy(&colour_word[c], colour_name[c], colour_length[c]);
+    memset(&colour_mask[c], 0xff, colour_length[c]);
+  }
+
+  GameLog log = {0};
+  const char* p = buf;
+  const char* end = buf + len;
+  while (p < end)
+  {
+    // Lines look like "Game 12: 3 blue, 4 red; 1 red, 2 green".
+    if (*p != 'G')
+    {
+      ++p;
+      continue;
+    }
+
+    if (end - p < 5 || memcmp(p, "Game ", 5)) bad_record(buf, p);
+    p += 5;
+    uint32_t id = 0;
+    while (p < end && is_digit(*p)) id = 10 * id + (*p++ - '0');
+    if (end - p < 2 || memcmp(p, ": ", 2)) bad_record(buf, p);
+    add_game(&log, id);
+    p += 2;
+
+    uint16_t max[NUM_COLOURS] = {0, 0, 0};
+    while (p < end)
+    {
+      const char* number = p;
+      uint32_t val = 0;
+      while (p < end && is_digit(*p)) val = 10 * val + (*p++ - '0');
+      if (p == number || p >= end || *p != ' ') bad_record(buf, p);
+      ++p;
+
+      const int colour = p < end ? colour_index[(unsigned char)*p] : -1;
+      if (colour < 0) bad_record(buf, p);
+      if (end - p >= 8)
+      {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        if ((word & colour_mask[colour]) != colour_word[colour]) bad_record(buf, p);
+      }
+      else if (end - p < colour_length[colour] || memcmp(p, colour_name[colour], colour_length[colour]))
+      {
+        bad_record(buf, p);
+      }
+      max[colour] = MAX(max[colour], val);
+
+      p += colour_length[colour];
+      if (p < end && *p == '\r') ++p;
+      if (p >= end || *p == '\n') break;
+      // Whether it's ',' or ';' is a coin toss, so the test mustn't branch on it.
+      if (end - p < 2 || !(((*p == ',') | (*p == ';')) & (p[1] == ' '))) bad_record(buf, p);
+      p += 2;
+    }
+
+    for (int c = 0; c < NUM_COLOURS; c++) log.max[c][log.num_games - 1] = max[c];
+  }
+
+  return log;
+}
+
+// Answers "which games are possible with this bag?" (part 1 asks it of a single bag)
+// without looking at the games again.
+//
+// A game fits in a bag if each of its maximums is no bigger than the bag's amount of that
+// colour, so the games that fit are those in a box with one corner at the origin. Each
+// colour's distinct maximums are ranked, and a cube holds the number of games (and the sum
+// of their ids) up to every combination of ranks: a 3D prefix sum. Any amount of a colour
+// is turned into a rank with a lookup table, so a query is four loads whatever the number
+// of games.
+//
+// When the ranks would make the cube unreasonably big (lots of games with wildly different
+// maximums), the cube is over blocks of ranks instead: each colour's ranks are grouped
+// 2^shift at a time, doubling the blocks of whichever colour has most of them until the
+// cube is small enough. The cube then counts the games in blocks wholly below the bag's,
+// and only the games in the bag's own block of some colour are looked at one by one, from
+// lists of the games in each block of each colour.
+
+// Cells (each 12 bytes) in the cube at most.
+#define MAX_CUBE_CELLS (1 << 22)
+
+typedef struct
+{
+  uint32_t count;
+  uint64_t id_sum;
+} Feasible;
+
+typedef struct
+{
+  const GameLog* log;
+
+  // Amounts above the biggest maximum of a colour rank the same as it.
+  uint16_t limit[NUM_COLOURS];
+
+  // Amount of a colour -> number of distinct maximums no bigger than it.
+  uint32_t* rank[NUM_COLOURS];
+
+  // Ranks per block of the cube are 1 << shift, so with every shift 0 the cube is exact.
+  int blocked;
+  uint8_t shift[NUM_COLOURS];
+
+  size_t dims[NUM_COLOURS];
+  uint32_t* count;
+  uint64_t* id_sum;
+
+  // Only when blocked: the games in order of their block of each colour, and where each
+  // block's games start.
+  uint32_t* by_block[NUM_COLOURS];
+  uint32_t* block_start[NUM_COLOURS];
+} FeasibilityIndex;
+
+static uint32_t game_block(const FeasibilityIndex* index, int colour, size_t game)
+{
+  return index->rank[colour][index->log->max[colour][game]] >> index->shift[colour];
+}
+
+FeasibilityIndex build_index(const GameLog* log)
+{
+  FeasibilityIndex index = {log};
+
+  size_t max_rank[NUM_COLOURS];
+  for (int c = 0; c < NUM_COLOURS; c++)
+  {
+    for (size_t i = 0; i < log->num_games; i++) index.limit[c] = MAX(index.limit[c], log->max[c][i]);
+
+    index.rank[c] = calloc(index.limit[c] + 1, sizeof(uint32_t));
+    for (size_t i = 0; i < log->num_games; i++) index.rank[c][log->max[c][i]] = 1;
+
+    uint32_t rank = 0;
+    for (size_t v = 0; v <= index.limit[c]; v++)
+    {
+      rank += index.rank[c][v];
+      index.rank[c][v] = rank;
+    }
+    max_rank[c] = rank;
+
+    // Rank 0 (nothing fits) gets a slice of the cube too.
+    index.dims[c] = rank + 1;
+  }
+
+  while (index.dims[RED] * index.dims[GREEN] * index.dims[BLUE] > MAX_CUBE_CELLS)
+  {
+    int widest = RED;
+    for (int c = GREEN; c < NUM_COLOURS; c++)
+    {
+      if (index.dims[c] > index.dims[widest]) widest = c;
+    }
+    ++index.shift[widest];
+    index.dims[widest] = (max_rank[widest] >> index.shift[widest]) + 1;
+    index.blocked = 1;
+  }
+
+  const size_t num_cells = index.dims[RED] * index.dims[GREEN] * index.dims[BLUE];
+  index.count = calloc(num_cells, sizeof(uint32_t));
+  index.id_sum = calloc(num_cells, sizeof(uint64_t));
+
+  const size_t dg = index.dims[GREEN], db = index.dims[BLUE];
+  for (size_t i = 0; i < log->num_games; i++)
+  {
+    const size_t cell =
+      (game_block(&index, RED, i) * dg + game_block(&index, GREEN, i)) * db + game_block(&index, BLUE, i);
+    ++index.count[cell];
+    index.id_sum[cell] += log->id[i];
+  }
+
+  // Accumulate along each axis in turn.
+  const size_t stride[NUM_COLOURS] = {dg * db, db, 1};
+  for (int c = 0; c < NUM_COLOURS; c++)
+  {
+    for (size_t cell = 0; cell < num_cells; cell++)
+    {
+      if ((cell / stride[c]) % index.dims[c] == 0) continue;
+      index.count[cell] += index.count[cell - stride[c]];
+      index.id_sum[cell] += index.id_sum[cell - stride[c]];
+    }
+  }
+
+  if (!index.blocked) return index;
+
+  // A counting sort of the games by each colour's block.
+  for (int c = 0; c < NUM_COLOURS; c++)
+  {
+    uint32_t* start = calloc(index.dims[c] + 1, sizeof(uint32_t));
+    for (size_t i = 0; i < log->num_games; i++) ++start[game_block(&index, c, i) + 1];
+    for (size_t k = 0; k < index.dims[c]; k++) start[k + 1] += start[k];
+
+    uint32_t* games = malloc(log->num_games * sizeof(uint32_t));
+    uint32_t* next = malloc(index.dims[c] * sizeof(uint32_t));
+    memcpy(next, start, index.dims[c] * sizeof(uint32_t));
+    for (size_t i = 0; i < log->num_games; i++) games[next[game_block(&index, c, i)]++] = i;
+    free(next);
+
+    index.by_block[c] = games;
+    index.block_start[c] = start;
+  }
+
+  return index;
+}
+
+void free_index(FeasibilityIndex* index)
+{
+  for (int c = 0; c < NUM_COLOURS; c++)
+  {
+    free(index->rank[c]);
+    free(index->by_block[c]);
+    free(index->block_start[c]);
+  }
+  free(index->count);
+  free(index->id_sum);
+}
+
+Feasible query_bag(const FeasibilityIndex* index, const uint16_t bag[NUM_COLOURS])
 {
-  FILE* f = fopen("input.txt", "r");
-  char buf[200];
-  int game_id;
-  int game_id_total = 0;
-  int game_power_total = 0;
-  while (fscanf(f, "Game %d: %[^\n]\n", &game_id, buf) != EOF)
+  Feasible result = {0, 0};
+  const GameLog* log = index->log;
+
+  size_t block[NUM_COLOURS];
+  for (int c = 0; c < NUM_COLOURS; c++)
+  {
+    block[c] = index->rank[c][bag[c] < index->limit[c] ? bag[c] : index->limit[c]] >> index->shift[c];
+  }
+
+  if (!index->blocked)
+  {
+    const size_t cell = (block[RED] * index->dims[GREEN] + block[GREEN]) * index->dims[BLUE] + block[BLUE];
+    result.count = index->count[cell];
+    result.id_sum = index->id_sum[cell];
+    return result;
+  }
+
+  // The games in blocks wholly below the bag's.
+  if (block[RED] && block[GREEN] && block[BLUE])
+  {
+    const size_t cell =
+      ((block[RED] - 1) * index->dims[GREEN] + block[GREEN] - 1) * index->dims[BLUE] + block[BLUE] - 1;
+    result.count = index->count[cell];
+    result.id_sum = index->id_sum[cell];
+  }
+
+  // Then those in the bag's own block of red, those below it in red but in its own block of
+  // green, and those below it in both but in its own block of blue, so none is counted twice.
+  for (int c = 0; c < NUM_COLOURS; c++)
   {
-    // Parsing the input is rather awkward (at least, it is in C).
-    // Rather than the going down the `strtok` route we can get by
-    // with a simple state machine.
-    enum parser_state
+    const uint32_t* games = index->by_block[c];
+    for (uint32_t j = index->block_start[c][block[c]]; j < index->block_start[c][block[c] + 1]; j++)
     {
-      NUMBER,
-      COLOUR,
-      NONE
-    };
-
-    int max_r = 0, max_g = 0, max_b = 0;
-    enum parser_state state = NONE;
-    int val = 0;
-    for (size_t i = 0; i < strlen(buf); i++)
+      const uint32_t i = games[j];
+      int fits = 1;
+      for (int d = 0; d < NUM_COLOURS; d++)
+      {
+        fits &= log->max[d][i] <= bag[d];
+        if (d < c) fits &= game_block(index, d, i) < block[d];
+      }
+
+      if (fits)
+      {
+        ++result.count;
+        result.id_sum += log->id[i];
+      }
+    }
+  }
+
+  return result;
+}
+
+#if defined(__x86_64__)
+
+// Eight bags at a time: the rank lookups and the cube lookups are all gathers. Returns how
+// many bags it got through.
+__attribute__((target("avx2")))
+static size_t query_bags_avx2(
+  const FeasibilityIndex* index,
+  const uint16_t* const bags[NUM_COLOURS],
+  size_t num_bags,
+  uint32_t* count,
+  uint64_t* id_sum)
+{
+  const __m256i dims_green = _mm256_set1_epi32(index->dims[GREEN]);
+  const __m256i dims_blue = _mm256_set1_epi32(index->dims[BLUE]);
+
+  size_t i = 0;
+  for (; i + 8 <= num_bags; i += 8)
+  {
+    __m256i rank[NUM_COLOURS];
+    for (int c = 0; c < NUM_COLOURS; c++)
     {
-      switch (state)
+      __m256i amount = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(bags[c] + i)));
+      amount = _mm256_min_epu32(amount, _mm256_set1_epi32(index->limit[c]));
+      rank[c] = _mm256_i32gather_epi32((const int*)index->rank[c], amount, 4);
+    }
+
+    __m256i cell = _mm256_add_epi32(_mm256_mullo_epi32(rank[RED], dims_green), rank[GREEN]);
+    cell = _mm256_add_epi32(_mm256_mullo_epi32(cell, dims_blue), rank[BLUE]);
+
+    _mm256_storeu_si256((__m256i*)(count + i), _mm256_i32gather_epi32((const int*)index->count, cell, 4));
+
+    const long long* sums = (const long long*)index->id_sum;
+    _mm256_storeu_si256((__m256i*)(id_sum + i), _mm256_i32gather_epi64(sums, _mm256_castsi256_si128(cell), 8));
+    _mm256_storeu_si256((__m256i*)(id_sum + i + 4), _mm256_i32gather_epi64(sums, _mm256_extracti128_si256(cell, 1), 8));
+  }
+
+  return i;
+}
+
+#endif
+
+// The same as query_bag for a whole batch of bags, given as a column per colour.
+void query_bags(
+  const FeasibilityIndex* index,
+  const uint16_t* const bags[NUM_COLOURS],
+  size_t num_bags,
+  uint32_t* count,
+  uint64_t* id_sum)
+{
+  size_t i = 0;
+#if defined(__x86_64__)
+  if (!index->blocked && __builtin_cpu_supports("avx2")) i = query_bags_avx2(index, bags, num_bags, count, id_sum);
+#endif
+
+  for (; i < num_bags; i++)
+  {
+    const uint16_t bag[NUM_COLOURS] = {bags[RED][i], bags[GREEN][i], bags[BLUE][i]};
+    const Feasible f = query_bag(index, bag);
+    count[i] = f.count;
+    id_sum[i] = f.id_sum;
+  }
+}
+
+char* read_input(const char* path, size_t* len)
+{
+  FILE* f = fopen(path, "rb");
+  if (!f) return NULL;
+
+  fseek(f, 0, SEEK_END);
+  *len = ftell(f);
+  fseek(f, 0, SEEK_SET);
+
+  char* buf = malloc(*len);
+  *len = fread(buf, 1, *len, f);
+  fclose(f);
+
+  return buf;
+}
+
+// Bags to query, as "<red> <green> <blue>" per line, into a column per colour.
+size_t read_bags(const char* path, uint16_t* bags[NUM_COLOURS])
+{
+  size_t len;
+  char* buf = read_input(path, &len);
+  if (!buf) return 0;
+
+  size_t num_bags = 0, capacity = 0;
+  int colour = 0;
+  uint32_t val = 0;
+  for (size_t i = 0; i <= len; i++)
+  {
+    if (i < len && is_digit(buf[i]))
+    {
+      val = 10 * val + (buf[i] - '0');
+      continue;
+    }
+    if (i > 0 && is_digit(buf[i - 1]))
+    {
+      if (num_bags == capacity)
+      {
+        capacity = capacity ? 2 * capacity : 1024;
+        for (int c = 0; c < NUM_COLOURS; c++) bags[c] = realloc(bags[c], capacity * sizeof(uint16_t));
+      }
+
+      bags[colour][num_bags] = val > UINT16_MAX ? UINT16_MAX : val;
+      val = 0;
+      if (++colour == NUM_COLOURS)
       {
-        case NONE:
-        {
-          if (isdigit(buf[i]))
-          {
-            val = buf[i] - '0';
-            state = NUMBER;
-          }
-          else if (isalpha(buf[i]))
-          {
-            // Completed an entry!
-            switch (buf[i])
-            {
-              case 'r': max_r = MAX(max_r, val); break;
-              case 'g': max_g = MAX(max_g, val); break;
-              case 'b': max_b = MAX(max_b, val); break;
-            }
-
-            state = COLOUR;
-          }
-          break;
-        }
-        case NUMBER:
-        {
-          if (isdigit(buf[i]))
-          {
-            val *= 10;
-            val += buf[i] - '0';
-          }
-          else
-          {
-            state = NONE;
-          }
-          break;
-        }
-        case COLOUR:
-        {
-          if (buf[i] == ' ')
-          {
-            state = NONE;
-          }
-          break;
-        }
+        colour = 0;
+        ++num_bags;
       }
     }
+  }
+
+  free(buf);
+  return num_bags;
+}
+
+// Usage: d2 [input] [bags]
+// With a file of bags, prints the number of games possible with each bag (and the sum of
+// their ids) before the answers.
+int main(int argc, char** argv)
+{
+  aoc_phase_timer* timer = aoc_phase_start("parse");
+
+  size_t len;
+  char* buf = read_input(argc > 1 ? argv[1] : "input.txt", &len);
+  if (!buf) return 1;
+
+  GameLog log = parse_games(buf, len);
+  free(buf);
+
+  FeasibilityIndex index = build_index(&log);
+
+  // Any extra bags are the same question as part 1, so they count towards it.
+  aoc_phase_next(timer, "P1");
 
-    // Are the maximums in range?
-    if (max_r <= 12 && max_g <= 13 && max_b <= 14)
+  if (argc > 2)
+  {
+    uint16_t* bags[NUM_COLOURS] = {NULL, NULL, NULL};
+    const size_t num_bags = read_bags(argv[2], bags);
+
+    uint32_t* count = malloc(num_bags * sizeof(uint32_t));
+    uint64_t* id_sum = malloc(num_bags * sizeof(uint64_t));
+    query_bags(&index, (const uint16_t* const*)bags, num_bags, count, id_sum);
+
+    for (size_t i = 0; i < num_bags; i++)
     {
-      printf("%d is possible: %d %d %d\n", game_id, max_r, max_g, max_b);
-      game_id_total += game_id;
+      printf("%u %llu\n", count[i], (unsigned long long)id_sum[i]);
     }
 
-    game_power_total += max_r * max_g * max_b;
+    free(count);
+    free(id_sum);
+    for (int c = 0; c < NUM_COLOURS; c++) free(bags[c]);
+  }
+
+  static const uint16_t bag[NUM_COLOURS] = {12, 13, 14};
+  const long game_id_total = query_bag(&index, bag).id_sum;
+
+  const uint16_t* r = log.max[RED];
+  const uint16_t* g = log.max[GREEN];
+  const uint16_t* b = log.max[BLUE];
+
+  aoc_phase_next(timer, "P2");
+
+  long game_power_total = 0;
+  for (size_t i = 0; i < log.num_games; i++)
+  {
+    game_power_total += (long)r[i] * g[i] * b[i];
   }
+  aoc_phase_stop(timer);
+
+  printf("P1: %ld, P2: %ld\n", game_id_total, game_power_total);
 
-  printf("P1: %d, P2: %d\n", game_id_total, game_power_total);
+  free_index(&index);
+  free_games(&log);
 
   return 0;
 }
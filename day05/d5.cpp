@@ -1,10 +1,21 @@
-#include <fstream>
-#include <iostream>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
 #include <limits>
-#include <string>
-#include <sstream>
+#include <optional>
+#include <string_view>
+#include <thread>
 #include <vector>
 
+#include "input.h"
+#include "phase.h"
+#include "scan.h"
+#include "solver.h"
+#include "work_stealing.h"
+
+namespace d5
+{
+
 struct Range
 {
   std::int64_t dest_start;
@@ -12,59 +23,213 @@ struct Range
   std::int64_t length;
 };
 
-std::int64_t stage_input_for_output(
-  const std::vector<Range>& stage,
-  std::int64_t output)
+// A whole stage (or several composed together) as a single function: values from
+// starts_[k] up to starts_[k + 1] get offsets_[k] added. The first piece starts at 0 and
+// the last one goes on forever (the almanac never deals in negative numbers). Neighbouring
+// pieces always have different offsets.
+class PiecewiseMap
+{
+public:
+  // The identity.
+  PiecewiseMap()
+    : starts_{0}, offsets_{0} {}
+
+  // A stage, whose ranges are sorted by source_start. Anything between them maps to itself.
+  explicit PiecewiseMap(const std::vector<Range>& stage)
+  {
+    std::int64_t pos = 0;
+    for (const Range& r : stage)
+    {
+      if (r.source_start > pos) add_piece(pos, 0);
+      add_piece(r.source_start, r.dest_start - r.source_start);
+      pos = r.source_start + r.length;
+    }
+
+    add_piece(pos, 0);
+  }
+
+  // The map which applies this one and then `next`.
+  PiecewiseMap then(const PiecewiseMap& next) const
+  {
+    static constexpr auto unbounded = std::numeric_limits<std::int64_t>::max();
+
+    PiecewiseMap composed;
+    composed.starts_.clear();
+    composed.offsets_.clear();
+
+    for (std::size_t k = 0; k < starts_.size(); k++)
+    {
+      // Where this piece's values end up, split up by the pieces of `next`.
+      const std::int64_t offset = offsets_[k];
+      const std::int64_t begin = starts_[k] + offset;
+      const std::int64_t end = k + 1 < starts_.size() ? starts_[k + 1] + offset : unbounded;
+
+      for (std::size_t j = next.find(begin); ; j++)
+      {
+        composed.add_piece(std::max(begin, next.starts_[j]) - offset, offset + next.offsets_[j]);
+        if (j + 1 == next.starts_.size() || next.starts_[j + 1] >= end) break;
+      }
+    }
+
+    return composed;
+  }
+
+  std::int64_t operator()(std::int64_t value) const
+  {
+    return value + offsets_[find(value)];
+  }
+
+  // Maps a whole batch of values. They're searched for eight at a time in lockstep so that
+  // the loads of one search overlap with those of the others rather than waiting on each
+  // other.
+  void map(const std::int64_t* values, std::int64_t* mapped, std::size_t num_values) const
+  {
+    static constexpr std::size_t lanes = 8;
+
+    std::size_t i = 0;
+    for (; i + lanes <= num_values; i += lanes)
+    {
+      std::size_t k[lanes] = {};
+      for (std::size_t len = starts_.size(); len > 1;)
+      {
+        const std::size_t half = len / 2;
+        for (std::size_t l = 0; l < lanes; l++)
+        {
+          k[l] = starts_[k[l] + half] <= values[i + l] ? k[l] + half : k[l];
+        }
+        len -= half;
+      }
+
+      for (std::size_t l = 0; l < lanes; l++) mapped[i + l] = values[i + l] + offsets_[k[l]];
+    }
+
+    for (; i < num_values; i++) mapped[i] = (*this)(values[i]);
+  }
+
+private:
+  std::vector<std::int64_t> starts_;
+  std::vector<std::int64_t> offsets_;
+
+  void add_piece(std::int64_t start, std::int64_t offset)
+  {
+    if (!offsets_.empty() && offsets_.back() == offset) return;
+    starts_.push_back(start);
+    offsets_.push_back(offset);
+  }
+
+  // Index of the piece containing the value: a binary search that compiles to conditional
+  // moves rather than branches.
+  std::size_t find(std::int64_t value) const
+  {
+    std::size_t k = 0;
+    for (std::size_t len = starts_.size(); len > 1;)
+    {
+      const std::size_t half = len / 2;
+      k = starts_[k + half] <= value ? k + half : k;
+      len -= half;
+    }
+
+    return k;
+  }
+};
+
+// Half open: [begin, end).
+struct Interval
+{
+  std::int64_t begin;
+  std::int64_t end;
+};
+
+// Sorts the intervals and merges any that overlap or touch, so the number of intervals
+// carried from stage to stage stays bounded by the number of ranges.
+void normalise(std::vector<Interval>& intervals)
 {
-  for (const Range& r : stage)
+  std::sort(
+    intervals.begin(),
+    intervals.end(),
+    [] (const Interval& i1, const Interval& i2) { return i1.begin < i2.begin; });
+
+  std::size_t num_merged = 0;
+  for (const Interval& i : intervals)
   {
-    std::int64_t potential_in = r.source_start + output - r.dest_start;
-    if (potential_in >= r.source_start && potential_in < r.source_start + r.length)
+    if (num_merged > 0 && i.begin <= intervals[num_merged - 1].end)
     {
-      return potential_in;
+      intervals[num_merged - 1].end = std::max(intervals[num_merged - 1].end, i.end);
+    }
+    else
+    {
+      intervals[num_merged++] = i;
     }
   }
 
-  return -1;
+  intervals.resize(num_merged);
 }
 
-bool does_seed_exist(std::int64_t seed, const std::vector<std::int64_t>& seeds)
+// Maps every value in the intervals through a stage (whose ranges are sorted by
+// source_start), splitting intervals wherever they cross the edge of a range. Values that
+// no range covers map to themselves.
+std::vector<Interval> map_intervals(
+  const std::vector<Range>& stage,
+  const std::vector<Interval>& intervals)
 {
-  for (std::size_t i = 0; i < seeds.size() / 2; i++)
+  std::vector<Interval> mapped;
+  for (Interval i : intervals)
   {
-    std::int64_t upper = seeds[2*i] + seeds[2*i + 1];
-    if (seed < upper && seed >= seeds[2*i])
+    // The first range that ends after the interval starts.
+    auto r = std::upper_bound(
+      stage.begin(),
+      stage.end(),
+      i.begin,
+      [] (std::int64_t value, const Range& r) { return value < r.source_start + r.length; });
+
+    while (i.begin < i.end)
     {
-      return true;
+      if (r == stage.end() || i.end <= r->source_start)
+      {
+        // Nothing else maps this interval.
+        mapped.push_back(i);
+        break;
+      }
+
+      if (i.begin < r->source_start)
+      {
+        // The gap before the range.
+        mapped.push_back(Interval{i.begin, r->source_start});
+        i.begin = r->source_start;
+      }
+
+      const std::int64_t piece_end = std::min(i.end, r->source_start + r->length);
+      const std::int64_t offset = r->dest_start - r->source_start;
+      mapped.push_back(Interval{i.begin + offset, piece_end + offset});
+
+      i.begin = piece_end;
+      ++r;
     }
   }
 
-  return false;
+  normalise(mapped);
+  return mapped;
 }
 
-int main()
+aoc::Answer solve(std::string_view input)
 {
-  std::ifstream fs("input.txt");
-  std::string line;
+  aoc::PhaseTimer timer("parse");
+
   std::vector<std::int64_t> seeds;
   std::vector<std::vector<Range>> almanac;
   std::vector<Range> current;
-  while (std::getline(fs, line))
+  for (std::string_view line : aoc::Lines(input))
   {
-    std::cout << line << std::endl;
+    if (line.empty()) continue;
+
     if (line.substr(0, 5) == "seeds")
     {
       // Parse seeds array.
-      std::stringstream ss(line);
-      std::string token;
-      ss >> token;
-      while (ss >> token)
+      aoc::NumberScanner scanner(line);
+      for (std::int64_t seed; scanner.next(seed);)
       {
-        seeds.push_back(std::stoull(token));
+        seeds.push_back(seed);
       }
-
-      // Skip empty line.
-      std::getline(fs, line);
     }
     else
     {
@@ -75,8 +240,11 @@ int main()
       }
       else
       {
+        aoc::NumberScanner scanner(line);
         Range r;
-        std::sscanf(line.c_str(), "%ld %ld %ld", &r.dest_start, &r.source_start, &r.length);
+        r.dest_start = scanner.next<std::int64_t>();
+        r.source_start = scanner.next<std::int64_t>();
+        r.length = scanner.next<std::int64_t>();
         current.push_back(r);
       }
     }
@@ -84,63 +252,87 @@ int main()
 
   if (!current.empty()) almanac.push_back(current);
 
-  auto lowest = std::numeric_limits<std::int64_t>::max();
-  for (auto seed : seeds)
+  for (auto& stage : almanac)
   {
-    for (const auto& stage : almanac)
+    std::sort(
+      stage.begin(),
+      stage.end(),
+      [] (const Range& r1, const Range& r2) { return r1.source_start < r2.source_start; });
+  }
+
+  timer.next("P1");
+
+  // Compose the whole almanac into one map up front, so that each seed is one search rather
+  // than a scan through every stage.
+  PiecewiseMap almanac_map;
+  for (const auto& stage : almanac)
+  {
+    almanac_map = almanac_map.then(PiecewiseMap(stage));
+  }
+
+  // Map the seeds a chunk at a time (in parallel when running on a pool), each chunk
+  // finding its own lowest location.
+  static constexpr std::size_t chunk_size = 1 << 14;
+  const std::size_t num_chunks = (seeds.size() + chunk_size - 1) / chunk_size;
+  std::vector<std::int64_t> chunk_lowest(num_chunks);
+  aoc::parallel_for(
+    num_chunks,
+    [&seeds, &almanac_map, &chunk_lowest] (std::size_t c)
     {
-      // Find the range which applies to this input.
-      for (const Range& r : stage)
-      {
-        if (seed >= r.source_start && seed < r.source_start + r.length)
-        {
-          seed += (r.dest_start - r.source_start);
-          break;
-        }
-      }
-    }
+      const std::size_t begin = c * chunk_size;
+      const std::size_t size = std::min(chunk_size, seeds.size() - begin);
+
+      std::vector<std::int64_t> locations(size);
+      almanac_map.map(seeds.data() + begin, locations.data(), size);
+      chunk_lowest[c] = *std::min_element(locations.begin(), locations.end());
+    });
 
-    lowest = std::min(lowest, seed);
+  auto lowest = std::numeric_limits<std::int64_t>::max();
+  for (auto location : chunk_lowest)
+  {
+    lowest = std::min(lowest, location);
   }
 
+  timer.next("P2");
+
   // P2.
-  // Backtrack and see what the lowest possible location we can reach is.
-  // To make this more efficient:
-  // 1) Step up from 0 in increments of 1000 until we find a valid seed.
-  // 2) Now step downwards one at a time until we are no longer a valid seed.
-  // This only works because the minimum seed is in a "range" of at least 1000 seeds.
-  // Seems like quite a safe bet given the large seed ranges we're dealing with.
-  std::int64_t test = -1;
-  std::int64_t step = 1000;
-  bool solution_found = false;
-  while (!solution_found)
+  // Push the seed ranges through the almanac whole, as intervals. However big the ranges
+  // are, each stage can only split them where its own ranges start and end, so the lowest
+  // location is just the start of the lowest interval at the end.
+  std::vector<Interval> intervals;
+  for (std::size_t i = 0; i + 1 < seeds.size(); i += 2)
   {
-next_try:
-    test += step;
-
-    auto current = test;
-    for (int i = almanac.size() - 1; i >= 0; i--)
-    {
-      current = stage_input_for_output(almanac[i], current);
-      if (current < 0) goto next_try;
-    }
+    if (seeds[i + 1] > 0) intervals.push_back(Interval{seeds[i], seeds[i] + seeds[i + 1]});
+  }
+  normalise(intervals);
 
-    // Is this in a seed range?
-    if (does_seed_exist(current, seeds))
-    {
-      if (step == 1000)
-      {
-        step = -1;
-      }
-    }
-    else if (step == -1)
-    {
-      test -= step;
-      solution_found = true;
-    }
+  for (const auto& stage : almanac)
+  {
+    intervals = map_intervals(stage, intervals);
   }
 
-  std::cout << "P1: " << lowest << ", P2: " << test << std::endl;
+  timer.stop();
+
+  // No seeds at all if there were no (non-empty) ranges.
+  std::optional<std::int64_t> lowest_p2;
+  if (!intervals.empty()) lowest_p2 = intervals.front().begin;
+
+  return {lowest, lowest_p2};
+}
+
+}
+
+#ifndef AOC_LIBRARY
+int main(int argc, char** argv)
+{
+  // Standalone, there's no pool for part 1's chunks to fork onto, so they'd go one after
+  // another. Solve on a pool of our own, a worker per core. (In process, callers bring their
+  // own threads, and a pool per solve there would only oversubscribe them.)
+  aoc::WorkStealingPool pool(std::max(1u, std::thread::hardware_concurrency()));
+  int status = EXIT_FAILURE;
+  pool.submit([argc, argv, &status] { status = aoc::solver_main(argc, argv, d5::solve); });
+  pool.join();
 
-  return 0;
+  return status;
 }
+#endif
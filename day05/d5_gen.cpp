@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <set>
+#include <vector>
+
+#include "generate.h"
+
+// Generates an almanac shaped like the real one: 10 seed ranges and seven stages which
+// each shuffle a partition of the 32 bit number line (~33 ranges per stage).
+// Scaling grows the number of ranges per stage and the number of seed ranges.
+
+constexpr std::int64_t upper = 1LL << 32;
+
+constexpr std::array<const char*, 7> stage_names = {
+  "seed-to-soil",
+  "soil-to-fertilizer",
+  "fertilizer-to-water",
+  "water-to-light",
+  "light-to-temperature",
+  "temperature-to-humidity",
+  "humidity-to-location"
+};
+
+// Sorted, distinct cut points splitting [0, upper) into `n` pieces.
+std::vector<std::int64_t> random_cuts(std::size_t n, std::mt19937_64& rng) {
+  std::set<std::int64_t> cuts{0, upper};
+  while (cuts.size() < n + 1) {
+    cuts.insert(aoc::uniform<std::int64_t>(rng, 1, upper - 1));
+  }
+
+  return std::vector<std::int64_t>(cuts.begin(), cuts.end());
+}
+
+int main(int argc, char** argv) {
+  auto [scale, rng] = aoc::parse_generator_args(argc, argv);
+
+  // Seed ranges: alternate pieces of a partition so that they never overlap.
+  const std::size_t num_seed_ranges = std::max(1.0, std::round(10 * scale));
+  const auto seed_cuts = random_cuts(2 * num_seed_ranges, rng);
+  std::printf("seeds:");
+  for (std::size_t i = 0; i < num_seed_ranges; i++) {
+    const auto start = seed_cuts[2 * i + 1];
+    std::printf(" %lld %lld", static_cast<long long>(start), static_cast<long long>(seed_cuts[2 * i + 2] - start));
+  }
+  std::printf("\n");
+
+  const std::size_t ranges_per_stage = std::max(1.0, std::round(33 * scale));
+  for (const char* name : stage_names) {
+    std::printf("\n%s map:\n", name);
+
+    // Cut the number line into pieces and lay them back down in a random order. Like the
+    // real input, the piece at the top is left unmapped (i.e. identity).
+    const auto cuts = random_cuts(ranges_per_stage + 1, rng);
+    std::vector<std::size_t> order(ranges_per_stage);
+    for (std::size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::shuffle(order.begin(), order.end(), rng);
+
+    std::int64_t dest = 0;
+    for (auto i : order) {
+      const auto length = cuts[i + 1] - cuts[i];
+      std::printf("%lld %lld %lld\n",
+        static_cast<long long>(dest), static_cast<long long>(cuts[i]), static_cast<long long>(length));
+      dest += length;
+    }
+  }
+}
@@ -1,76 +1,222 @@
+#include <algorithm>
 #include <cmath>
-#include <fstream>
-#include <iostream>
-#include <string>
-#include <sstream>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <string_view>
 #include <vector>
 
-std::vector<int> parse_array(const std::string& line, std::int64_t& combined)
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "input.h"
+#include "phase.h"
+#include "scan.h"
+#include "solver.h"
+
+namespace d6
 {
-  std::vector<int> data;
-  std::stringstream ss(line);
-  std::string token, concat;
-  while (ss >> token)
+
+// time^2 needs up to 128 bits.
+__extension__ typedef unsigned __int128 Wide;
+
+std::vector<std::uint64_t> parse_array(std::string_view line)
+{
+  std::vector<std::uint64_t> data;
+  aoc::NumberScanner scanner(line);
+  for (std::uint64_t value; scanner.next(value);)
   {
-    data.push_back(std::stoi(token));
-    concat += token;
+    data.push_back(value);
   }
 
-  combined = std::stoull(concat);
   return data;
 }
 
-std::int64_t count_winning_times(std::int64_t time, std::int64_t record)
+// What we'd get by concatenating all of the digits, if it fits in 64 bits.
+std::optional<std::uint64_t> concatenate(const std::vector<std::uint64_t>& values)
+{
+  std::uint64_t combined = 0;
+  for (std::uint64_t value : values)
+  {
+    // Shift the combined value along to make room for this one's digits.
+    std::uint64_t rest = value;
+    do
+    {
+      if (__builtin_mul_overflow(combined, 10, &combined)) return std::nullopt;
+      rest /= 10;
+    } while (rest > 0);
+    if (__builtin_add_overflow(combined, value, &combined)) return std::nullopt;
+  }
+
+  return combined;
+}
+
+// floor(sqrt(n)).
+std::uint64_t isqrt(Wide n)
+{
+  // A long double has (at least) a 64 bit mantissa, so this is within a step or two.
+  const long double estimate = std::sqrt(static_cast<long double>(n));
+  Wide root = estimate < 18446744073709551615.0L ? static_cast<std::uint64_t>(estimate) : ~std::uint64_t(0);
+
+  while (root * root > n) root--;
+  while (root < ~std::uint64_t(0) && (root + 1) * (root + 1) <= n) root++;
+
+  return root;
+}
+
+// Holding the button for h of the race's time milliseconds goes h * (time - h) millimetres.
+// The holds that beat the record are the ones strictly between the roots of
+// h^2 - time h + record, a window symmetric about time / 2.
+std::uint64_t count_winning_times(std::uint64_t time, std::uint64_t record)
 {
-  // Need double precision for P2.
-  double td = time;
-  double rd = record;
+  const auto beats = [time, record] (std::uint64_t hold)
+  {
+    return Wide(hold) * (time - hold) > record;
+  };
+
+  // Nothing goes further than holding for half the time.
+  if (!beats(time / 2)) return 0;
+
+  // The lower root is (time - sqrt(disc)) / 2, and rounding the square root down puts this
+  // either on the first winning hold or just before it.
+  const Wide disc = Wide(time) * time - 4 * Wide(record);
+  std::uint64_t first = (time - isqrt(disc)) / 2;
+  if (!beats(first)) first++;
+
+  return time - 2 * first + 1;
+}
+
+#if defined(__x86_64__)
+
+// Four races at once, as long as they're small enough (time < 2^26, record < 2^50) that the
+// roots can be worked out in doubles without any rounding before the square root, and every
+// distance fits in the low 52 bits. False, leaving counts alone, if any of them isn't.
+__attribute__((target("avx2")))
+bool count_winning_times_avx2(const std::uint64_t* times, const std::uint64_t* records, std::uint64_t* counts)
+{
+  const __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(times));
+  const __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(records));
+
+  const __m256i too_big = _mm256_or_si256(_mm256_srli_epi64(t, 26), _mm256_srli_epi64(r, 50));
+  if (!_mm256_testz_si256(too_big, too_big)) return false;
 
-  double upper = 0.5 * (td + std::sqrt(td * td - 4 * rd));
-  double lower = 0.5 * (td - std::sqrt(td * td - 4 * rd));
+  // An integer below 2^52 sits in the low bits of the double 2^52 + that integer, which
+  // is how they're converted both ways (AVX2 has no 64 bit integer conversions).
+  const __m256i magic = _mm256_set1_epi64x(0x4330000000000000);
+  const __m256d magic_pd = _mm256_castsi256_pd(magic);
+  const __m256d td = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(t, magic)), magic_pd);
+  const __m256d rd = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(r, magic)), magic_pd);
 
-  // Annoying special case when the bounds are integers.
-  if (upper == std::round(upper) && lower == std::round(lower))
+  const __m256d disc = _mm256_max_pd(
+    _mm256_sub_pd(_mm256_mul_pd(td, td), _mm256_mul_pd(_mm256_set1_pd(4), rd)), _mm256_setzero_pd());
+  const __m256d lower = _mm256_floor_pd(_mm256_mul_pd(_mm256_set1_pd(0.5), _mm256_sub_pd(td, _mm256_sqrt_pd(disc))));
+  __m256i first = _mm256_xor_si256(_mm256_castpd_si256(_mm256_add_pd(lower, magic_pd)), magic);
+
+  // The rounded square root leaves that up to two short of the first winning hold.
+  const __m256i one = _mm256_set1_epi64x(1);
+  for (int i = 0; i < 2; i++)
   {
-    return upper - lower - 1;
+    const __m256i distance = _mm256_mul_epu32(first, _mm256_sub_epi64(t, first));
+    first = _mm256_add_epi64(first, _mm256_andnot_si256(_mm256_cmpgt_epi64(distance, r), one));
   }
 
-  return std::floor(upper) - std::ceil(lower) + 1;
+  // Zero for the races that can't be won at all.
+  const __m256i half = _mm256_srli_epi64(t, 1);
+  const __m256i best = _mm256_mul_epu32(half, _mm256_sub_epi64(t, half));
+  const __m256i count = _mm256_add_epi64(_mm256_sub_epi64(t, _mm256_add_epi64(first, first)), one);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(counts), _mm256_and_si256(count, _mm256_cmpgt_epi64(best, r)));
+
+  return true;
+}
+
+#endif
+
+// count_winning_times() for a whole table of races: counts[i] is the number of ways to win
+// race i. Small races go through four at a time in doubles, the rest one at a time exactly.
+void count_winning_times(const std::uint64_t* times, const std::uint64_t* records, std::size_t n, std::uint64_t* counts)
+{
+  std::size_t i = 0;
+#if defined(__x86_64__)
+  if (__builtin_cpu_supports("avx2"))
+  {
+    for (; i + 4 <= n; i += 4)
+    {
+      if (!count_winning_times_avx2(times + i, records + i, counts + i))
+      {
+        for (std::size_t j = i; j < i + 4; j++) counts[j] = count_winning_times(times[j], records[j]);
+      }
+    }
+  }
+#endif
+
+  for (; i < n; i++)
+  {
+    counts[i] = count_winning_times(times[i], records[i]);
+  }
 }
 
-int main()
+aoc::Answer solve(std::string_view input)
 {
-  std::ifstream fs("input.txt");
-  std::string line;
-  std::vector<int> times, distances;
-  std::int64_t times2 = 0, distances2 = 0;
-  while (std::getline(fs, line))
+  aoc::PhaseTimer timer("parse");
+
+  std::vector<std::uint64_t> times, distances;
+  for (std::string_view line : aoc::Lines(input))
   {
     line = line.substr(12);
     if (times.empty())
     {
-      times = parse_array(line, times2);
+      times = parse_array(line);
     }
     else
     {
-      distances = parse_array(line, distances2);
+      distances = parse_array(line);
     }
   }
 
-  int prod = 1;
-  for (std::size_t i = 0; i < times.size(); i++)
+  if (distances.size() != times.size()) std::abort();
+
+  timer.next("P1");
+
+  std::vector<std::uint64_t> counts(times.size());
+  count_winning_times(times.data(), distances.data(), times.size(), counts.data());
+
+  // Left unanswered if the product doesn't fit.
+  std::optional<std::int64_t> prod = 1;
+  for (std::uint64_t count : counts)
   {
-    std::cout << times[i] << " " << distances[i] << std::endl;
+    std::int64_t next;
+    if (count > INT64_MAX || __builtin_mul_overflow(*prod, static_cast<std::int64_t>(count), &next))
+    {
+      prod.reset();
+      break;
+    }
+    prod = next;
+  }
 
-    int count = count_winning_times(times[i], distances[i]);
-    std::cout << "Count: " << count << std::endl;
-    prod *= count;
+  timer.next("P2");
+
+  // Beyond a handful of races the concatenated numbers don't fit in 64 bits, and neither
+  // would the answer.
+  std::optional<std::int64_t> count;
+  const std::optional<std::uint64_t> time = concatenate(times);
+  const std::optional<std::uint64_t> distance = concatenate(distances);
+  if (time && distance)
+  {
+    const std::uint64_t wins = count_winning_times(*time, *distance);
+    if (wins <= INT64_MAX) count = wins;
   }
 
-  std::cout << "P2 input: " << times2 << " " << distances2 << std::endl;
-  int count = count_winning_times(times2, distances2);
+  timer.stop();
+
+  return {prod, count};
+}
 
-  std::cout << "P1: " << prod << ", P2: " << count << std::endl;
+}
 
-  return 0;
+#ifndef AOC_LIBRARY
+int main(int argc, char** argv)
+{
+  return aoc::solver_main(argc, argv, d6::solve);
 }
+#endif
@@ -0,0 +1,32 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "generate.h"
+
+// Generates a race table like the real one (four races with two digit times).
+// Scaling grows the number of races. Note that part 2 concatenates every race into a single
+// number, so beyond a handful of races the combined values no longer fit in 64 bits.
+
+int main(int argc, char** argv) {
+  auto [scale, rng] = aoc::parse_generator_args(argc, argv);
+
+  const std::size_t num_races = std::max(1.0, std::round(4 * scale));
+  std::vector<std::int64_t> times, records;
+  for (std::size_t i = 0; i < num_races; i++) {
+    const auto time = aoc::uniform<std::int64_t>(rng, 30, 99);
+
+    // The best possible distance is (time / 2)^2 so pick a record that can still be beaten.
+    const std::int64_t best = (time / 2) * (time - time / 2);
+    times.push_back(time);
+    records.push_back(aoc::uniform<std::int64_t>(rng, best / 2, best - 1));
+  }
+
+  std::printf("Time:       ");
+  for (auto t : times) std::printf(" %6lld", static_cast<long long>(t));
+  std::printf("\nDistance:   ");
+  for (auto r : records) std::printf(" %6lld", static_cast<long long>(r));
+  std::printf("\n");
+}
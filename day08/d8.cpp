@@ -1,126 +1,513 @@
-#include <fstream>
-#include <functional>
-#include <iostream>
-#include <string>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <string_view>
 #include <vector>
 
-std::uint64_t gcd(std::uint64_t a, std::uint64_t b)
+#include "input.h"
+#include "labels.h"
+#include "phase.h"
+#include "solver.h"
+#include "work_stealing.h"
+
+#include "d8_walk.h"
+
+namespace d8
+{
+
+// Step counts for all of the ghosts together can need up to 128 bits.
+__extension__ typedef unsigned __int128 Wide;
+__extension__ typedef __int128 SignedWide;
+
+Wide gcd(Wide a, Wide b)
 {
-  if (a > b) return gcd(b, a);
-  int tmp;
-  while (a)
+  while (b)
   {
-    tmp = a;
-    a = b % a;
+    const Wide tmp = a % b;
+    a = b;
     b = tmp;
   }
 
-  return b;
+  return a;
 }
 
-struct Node
+// x with a * x = 1 (mod m), for a coprime to m.
+std::uint64_t inverse(std::uint64_t a, std::uint64_t m)
 {
-  std::string label;
-  std::string left_label;
-  std::string right_label;
-  const Node* left;
-  const Node* right;
+  // Extended Euclid, only keeping track of the coefficient of a.
+  SignedWide r0 = a % m, r1 = m, s0 = 1, s1 = 0;
+  while (r1)
+  {
+    const SignedWide q = r0 / r1;
+    SignedWide tmp = r0 - q * r1;
+    r0 = r1;
+    r1 = tmp;
+    tmp = s0 - q * s1;
+    s0 = s1;
+    s1 = tmp;
+  }
+
+  s0 %= static_cast<SignedWide>(m);
+  return static_cast<std::uint64_t>(s0 < 0 ? s0 + m : s0);
+}
+
+// Where a ghost ends up on ..Z nodes. Its state is the node it's on and where it is in the
+// directions, so after at most (nodes * directions) steps a state comes round again, and
+// from then on its walk repeats exactly. Steps before that are the tail (here always a
+// whole number of passes through the directions, which needn't be the shortest tail).
+struct GhostCycle
+{
+  std::uint64_t tail = 0;
+  std::uint64_t length = 0;
+  std::vector<std::uint64_t> tail_hits;  // Steps before the cycle that are on a ..Z node
+  std::vector<std::uint64_t> cycle_hits; // Step % length for those in the cycle, sorted
 };
 
-const Node* find_node(const std::string& label, const std::vector<Node>& nodes)
+GhostCycle find_cycle(const PassTable& passes, std::uint32_t start)
 {
-  for (const auto& n : nodes)
+  // Brent's algorithm: the tortoise waits at each power of two for the hare to catch it up,
+  // which finds the cycle length in one walk round it (plus the tail). It only needs to
+  // look at the start of each pass, where the direction index is always 0, so the state is
+  // just the node and each move is one lookup.
+  std::uint64_t power = 1;
+  std::uint64_t length = 1;
+  std::uint32_t tortoise = start;
+  std::uint32_t hare = passes.after_pass(start);
+  while (tortoise != hare)
+  {
+    if (power == length)
+    {
+      tortoise = hare;
+      power *= 2;
+      length = 0;
+    }
+    hare = passes.after_pass(hare);
+    ++length;
+  }
+
+  // With the hare a cycle length ahead, they meet where the cycle starts.
+  std::uint64_t tail = 0;
+  tortoise = hare = start;
+  for (std::uint64_t i = 0; i < length; i++) hare = passes.after_pass(hare);
+  while (tortoise != hare)
+  {
+    tortoise = passes.after_pass(tortoise);
+    hare = passes.after_pass(hare);
+    ++tail;
+  }
+
+  GhostCycle cycle;
+  cycle.tail = tail * passes.pass_length();
+  cycle.length = length * passes.pass_length();
+
+  std::uint32_t node = start;
+  for (std::uint64_t p = 0; p < tail + length; p++)
   {
-    if (n.label == label) return &n;
+    const std::uint64_t pass_start = p * passes.pass_length();
+    passes.for_each_hit(node, [&cycle, pass_start] (std::uint32_t i)
+    {
+      const std::uint64_t step = pass_start + i;
+      if (step < cycle.tail) cycle.tail_hits.push_back(step);
+      else cycle.cycle_hits.push_back(step % cycle.length);
+    });
+    node = passes.after_pass(node);
   }
+  std::sort(cycle.cycle_hits.begin(), cycle.cycle_hits.end());
 
-  return nullptr;
+  return cycle;
 }
 
-int steps_to_reach_target(
-  const Node& start,
-  const std::string& directions,
-  std::function<bool(const Node*)> check)
+bool is_hit(const GhostCycle& cycle, Wide steps)
 {
-  int num_steps = 0;
-  int index = -1;
-  const Node* current = &start;
-  while (!check(current))
+  if (steps < cycle.tail)
+  {
+    return std::binary_search(cycle.tail_hits.begin(), cycle.tail_hits.end(), steps);
+  }
+  return std::binary_search(cycle.cycle_hits.begin(), cycle.cycle_hits.end(), steps % cycle.length);
+}
+
+// The first step at which every ghost is on a ..Z node at once. Nothing if that never
+// happens (or needs more than 128 bits).
+std::optional<Wide> first_common_hit(const std::vector<GhostCycle>& cycles)
+{
+  if (cycles.empty()) return 0;
+
+  std::uint64_t tail = 0;
+  for (const GhostCycle& c : cycles) tail = std::max(tail, c.tail);
+
+  // Until every ghost is round to its cycle, go through the first one's hits in order.
+  const GhostCycle& first = cycles.front();
+  std::vector<std::uint64_t> early(first.tail_hits.begin(), first.tail_hits.end());
+  for (std::uint64_t hit : first.cycle_hits)
+  {
+    std::uint64_t steps = first.tail + (hit + first.length - first.tail % first.length) % first.length;
+    for (; steps < tail; steps += first.length) early.push_back(steps);
+  }
+  std::sort(early.begin(), early.end());
+
+  for (std::uint64_t steps : early)
+  {
+    if (std::all_of(cycles.begin(), cycles.end(), [steps] (const GhostCycle& c) { return is_hit(c, steps); }))
+    {
+      return steps;
+    }
+  }
+
+  // After that each ghost is on ..Z exactly when steps % length is one of its cycle hits,
+  // so the answer is the smallest solution (past the tails) of one of the systems of
+  // congruences, one hit per ghost. Those are solved a ghost at a time with the
+  // generalised CRT, which copes with lengths that aren't coprime (they're all multiples of
+  // the number of directions, for a start): x = a (mod m) and x = b (mod n) have a solution
+  // only if a = b (mod gcd(m, n)), and then it's unique mod lcm(m, n).
+  //
+  // That's a residue for every combination of the ghosts' hits, though, which gets out of
+  // hand for ghosts that are on ..Z a lot of the time. So the ghosts are combined sparsest
+  // first, only while there are few enough residues (and the modulus fits), and any left
+  // over are checked against each solution of the rest in turn instead.
+  static constexpr std::size_t max_residues = 1 << 16;
+
+  std::vector<const GhostCycle*> order;
+  for (const GhostCycle& c : cycles) order.push_back(&c);
+  std::sort(order.begin(), order.end(), [] (const GhostCycle* a, const GhostCycle* b)
+  {
+    return Wide(a->cycle_hits.size()) * b->length < Wide(b->cycle_hits.size()) * a->length;
+  });
+
+  std::vector<Wide> residues = {0};
+  Wide modulus = 1;
+  std::vector<const GhostCycle*> unmerged;
+  for (const GhostCycle* c : order)
+  {
+    const std::uint64_t n = c->length;
+    const Wide g = gcd(modulus, n);
+    const std::uint64_t reduced = n / g;
+    Wide combined_modulus;
+    if (!unmerged.empty()
+      || residues.size() * c->cycle_hits.size() > max_residues
+      || __builtin_mul_overflow(modulus, reduced, &combined_modulus))
+    {
+      unmerged.push_back(c);
+      continue;
+    }
+
+    const std::uint64_t step_inverse = inverse(modulus / g % reduced, reduced);
+
+    std::vector<Wide> combined;
+    for (Wide a : residues)
+    {
+      for (std::uint64_t b : c->cycle_hits)
+      {
+        // Looking for x = a + modulus * t with modulus * t = b - a (mod n).
+        const Wide diff = (Wide(b) + n - a % n) % n;
+        if (diff % g) continue;
+
+        const Wide t = diff / g % reduced * step_inverse % reduced;
+        combined.push_back(a + modulus * t);
+      }
+    }
+
+    residues = std::move(combined);
+    modulus = combined_modulus;
+    if (residues.empty()) return std::nullopt;
+  }
+
+  if (unmerged.empty())
   {
-    ++num_steps;
-    ++index;
-    index %= directions.size();
-    if (directions[index] == 'L') current = current->left;
-    else current = current->right;
+    std::optional<Wide> best;
+    for (Wide x : residues)
+    {
+      if (x < tail) x += (tail - x + modulus - 1) / modulus * modulus;
+      if (!best || x < *best) best = x;
+    }
+
+    return best;
   }
 
-  return num_steps;
+  // Go through the solutions in order, a modulus at a time. Everything repeats after the
+  // lcm of all of the lengths, so nothing turning up by then means it never will.
+  std::sort(residues.begin(), residues.end());
+
+  Wide period = modulus;
+  bool bounded = true;
+  for (const GhostCycle* c : unmerged)
+  {
+    bounded = bounded && !__builtin_mul_overflow(period / gcd(period, c->length), c->length, &period);
+  }
+
+  // The first block starts at or below the tail, so the end of the search is counted from
+  // the tail itself rather than from the block.
+  Wide end = 0;
+  bounded = bounded && !__builtin_add_overflow(Wide(tail), period, &end);
+
+  const Wide max = ~Wide(0);
+  for (Wide base = tail / modulus * modulus; !bounded || base < end; base += modulus)
+  {
+    for (Wide r : residues)
+    {
+      const Wide steps = base + r;
+      if (steps < tail) continue;
+      if (std::all_of(unmerged.begin(), unmerged.end(), [steps] (const GhostCycle* c) { return is_hit(*c, steps); }))
+      {
+        return steps;
+      }
+    }
+
+    if (base > max - 2 * modulus) break;
+  }
+
+  return std::nullopt;
 }
 
-int main()
+// The first step at which walks from all of the starts are on ..Z nodes at once, from each
+// one's cycle.
+std::optional<Wide> first_common_hit(
+  const Network& network,
+  const std::vector<std::uint8_t>& directions,
+  const std::vector<std::uint32_t>& starts)
 {
-  std::ifstream fs("input.txt");
-  std::string directions; // The first line
-  std::vector<Node> nodes;
+  const PassTable passes(network, directions, network.ends_with_z);
+  std::vector<GhostCycle> cycles(starts.size());
+  aoc::parallel_for(cycles.size(), [&passes, &starts, &cycles] (std::size_t i)
+  {
+    cycles[i] = find_cycle(passes, starts[i]);
+  });
 
-  std::string line;
-  while (std::getline(fs, line))
+  return first_common_hit(cycles);
+}
+
+// Real inputs (and d8_gen's) are built so that each ghost first reaches a ..Z node after a
+// whole number of passes, and from there comes back to that node, and no other ..Z node,
+// every time it's gone as far again. Its hits are then just the multiples of the first one,
+// so the first common hit is their lcm. Given how far each walk from the starts took to its
+// first ..Z node, and where that was, this checks the rest with a second walk from there.
+// Nothing if any of them doesn't fit the pattern (or the lcm needs more than 128 bits).
+std::optional<Wide> lcm_of_clean_loops(
+  const Network& network,
+  const std::vector<std::uint8_t>& directions,
+  const std::vector<std::uint64_t>& first,
+  const std::vector<std::uint32_t>& hits)
+{
+  const std::size_t n = first.size();
+  const std::uint64_t pass = directions.size();
+  const auto on_z = [&network] (std::uint32_t node) { return network.ends_with_z[node] != 0; };
+
+  std::vector<std::uint32_t> nodes(hits);
+  std::vector<std::uint64_t> again(n);
+  steps_to_reach_targets(network, directions, on_z, 1, network.left.size() * pass, nodes.data(), again.data(), n);
+
+  Wide lcm = 1;
+  for (std::size_t i = 0; i < n; i++)
+  {
+    if (first[i] == never || first[i] == 0 || first[i] % pass || again[i] != first[i] || nodes[i] != hits[i])
+    {
+      return std::nullopt;
+    }
+    if (__builtin_mul_overflow(lcm / gcd(lcm, first[i]), first[i], &lcm)) return std::nullopt;
+  }
+
+  return lcm;
+}
+
+// Reads the directions (0 for L and 1 for R) and the network, interning its labels.
+Network load(std::string_view input, aoc::LabelInterner& ids, std::vector<std::uint8_t>& directions)
+{
+  Network network;
+
+  // Ids are handed out as labels turn up, wherever that is, so nodes can be linked as
+  // they're read.
+  std::vector<std::uint8_t> defined;
+
+  for (std::string_view line : aoc::Lines(input))
   {
     if (line.empty()) continue;
 
     if (directions.empty())
     {
-      directions = line;
+      for (char c : line) directions.push_back(c == 'R');
       continue;
     }
 
-    nodes.push_back(Node
+    const std::uint32_t id = ids.intern(line.substr(0, 3));
+    const std::uint32_t left = ids.intern(line.substr(7, 3));
+    const std::uint32_t right = ids.intern(line.substr(12, 3));
+    if (network.left.size() < ids.size())
     {
-      line.substr(0, 3),
-      line.substr(7, 3),
-      line.substr(12, 3),
-      nullptr,
-      nullptr
-    });
+      network.left.resize(ids.size());
+      network.right.resize(ids.size());
+      defined.resize(ids.size());
+    }
+
+    network.left[id] = left;
+    network.right[id] = right;
+    defined[id] = 1;
   }
 
-  // Iterate again and link nodes up.
-  const Node* start = nullptr, *end = nullptr;
-  for (Node& n : nodes)
+  // A node that's linked to but never listed would otherwise quietly lead to node 0.
+  if (std::find(defined.begin(), defined.end(), 0) != defined.end()) std::abort();
+
+  network.ends_with_z.resize(ids.size());
+  for (std::uint32_t id = 0; id < ids.size(); id++)
   {
-    const Node* l = find_node(n.left_label, nodes);
-    const Node* r = find_node(n.right_label, nodes);
+    const char last = ids.label(id)[2];
+    network.ends_with_z[id] = last == 'Z';
+    if (last == 'A') network.ends_with_a.push_back(id);
+  }
 
-    n.left = l;
-    n.right = r;
+  return network;
+}
+
+aoc::Answer solve(std::string_view input)
+{
+  aoc::PhaseTimer timer("parse");
 
-    if (n.label == "AAA") start = &n;
-    if (n.label == "ZZZ") end = &n;
+  aoc::LabelInterner ids(aoc::uppercase_and_digits, 3);
+  std::vector<std::uint8_t> directions;
+  const Network network = load(input, ids, directions);
+
+  const std::uint32_t start = ids.find("AAA");
+  const std::uint32_t end = ids.find("ZZZ");
+
+  timer.next("P1");
+
+  // P1 (the part 2 examples don't have AAA)
+  std::uint64_t p1_steps = 0;
+  if (start != aoc::LabelInterner::none && end != aoc::LabelInterner::none)
+  {
+    p1_steps = steps_to_reach_target(
+      network,
+      start,
+      directions,
+      [end] (std::uint32_t n) { return n == end; });
+    if (p1_steps == never) p1_steps = 0;
   }
 
-  // P1
-  int p1_steps = steps_to_reach_target(
-    *start,
-    directions,
-    [end] (const Node* n) { return n == end; });
+  timer.next("P2");
 
   // P2
-  std::uint64_t lcm = 1;
-  for (const Node& n : nodes)
+  const std::optional<Wide> common = first_common_hit(network, directions, network.ends_with_a);
+
+  std::optional<std::int64_t> p2_steps;
+  if (common && *common <= static_cast<Wide>(INT64_MAX)) p2_steps = static_cast<std::int64_t>(*common);
+
+  timer.stop();
+
+  return {static_cast<std::int64_t>(p1_steps), p2_steps};
+}
+
+}
+
+#ifndef AOC_LIBRARY
+namespace d8
+{
+
+// Usage: d8 [input] [queries]
+// Instead of solving, answers a file of queries about walks through the network, each a
+// start label on a line:
+// * followed by a number of steps: prints where the walk is after that many steps, and the
+//   first step within them that's on a ..Z node.
+// * on its own: prints the ..Z node the walk reaches first, and after how many steps.
+//   Then, after all of the queries, the first step at which every one of those walks is on
+//   a ..Z node at once (part 2 for just those ghosts).
+// "-" for anything that never happens.
+int answer_queries(const char* input_path, const char* queries_path)
+{
+  const aoc::Input input(input_path);
+  aoc::LabelInterner ids(aoc::uppercase_and_digits, 3);
+  std::vector<std::uint8_t> directions;
+  const Network network = load(input.data(), ids, directions);
+
+  // Each sort of query is answered for all of them at once, so they're collected first.
+  const aoc::Input queries(queries_path);
+  std::vector<std::uint32_t> walk_starts, ghost_starts;
+  std::vector<std::uint64_t> walk_steps;
+  std::vector<std::uint8_t> is_ghost;
+  for (std::string_view line : aoc::Lines(queries.data()))
   {
-    if (n.label[2] != 'A') continue;
-    int num_steps = steps_to_reach_target(
-      n,
-      directions,
-      [] (const Node* n) { return n->label[2] == 'Z'; });
+    const std::string_view label = aoc::next_token(line);
+    if (label.empty()) continue;
+
+    const std::uint32_t start = ids.find(label);
+    if (start == aoc::LabelInterner::none)
+    {
+      std::fprintf(stderr, "Unknown node %.*s\n", static_cast<int>(label.size()), label.data());
+      return EXIT_FAILURE;
+    }
 
-    // Update the LCM.
-    auto d = gcd(lcm, num_steps);
-    lcm *= num_steps;
-    lcm /= d;
+    const std::string_view steps = aoc::next_token(line);
+    is_ghost.push_back(steps.empty());
+    if (steps.empty())
+    {
+      ghost_starts.push_back(start);
+    }
+    else
+    {
+      walk_starts.push_back(start);
+      walk_steps.push_back(aoc::to_number<std::uint64_t>(steps));
+    }
   }
 
-  std::cout << "P1: " << p1_steps << ", P2: " << lcm << std::endl;
+  const std::uint64_t longest = walk_steps.empty() ? 0 : *std::max_element(walk_steps.begin(), walk_steps.end());
+  const PassTable passes(network, directions, network.ends_with_z, longest);
+  std::vector<std::uint32_t> walk_ends(walk_starts.size());
+  std::vector<std::uint64_t> walk_hits(walk_starts.size());
+  passes.position(walk_starts.data(), walk_steps.data(), walk_starts.size(), walk_ends.data());
+  passes.first_hit(walk_starts.data(), walk_steps.data(), walk_starts.size(), walk_hits.data());
+
+  std::vector<std::uint32_t> ghost_ends(ghost_starts);
+  std::vector<std::uint64_t> ghost_hits(ghost_starts.size());
+  steps_to_reach_targets(
+    network,
+    directions,
+    [&network] (std::uint32_t node) { return network.ends_with_z[node] != 0; },
+    0,
+    network.left.size() * directions.size(),
+    ghost_ends.data(),
+    ghost_hits.data(),
+    ghost_starts.size());
+
+  const auto print = [&ids] (std::uint32_t node, std::uint64_t steps)
+  {
+    const std::string_view label = node == aoc::LabelInterner::none ? "-" : ids.label(node);
+    std::printf("%.*s ", static_cast<int>(label.size()), label.data());
+    if (steps == never) std::printf("-\n");
+    else std::printf("%llu\n", static_cast<unsigned long long>(steps));
+  };
 
-  return 0;
+  std::size_t walk = 0, ghost = 0;
+  for (std::uint8_t g : is_ghost)
+  {
+    if (!g)
+    {
+      print(walk_ends[walk], walk_hits[walk]);
+      ++walk;
+    }
+    else
+    {
+      print(ghost_hits[ghost] == never ? aoc::LabelInterner::none : ghost_ends[ghost], ghost_hits[ghost]);
+      ++ghost;
+    }
+  }
+
+  if (!ghost_starts.empty())
+  {
+    // The walks are already done for the lcm, which is nearly always all it takes.
+    std::optional<Wide> common = lcm_of_clean_loops(network, directions, ghost_hits, ghost_ends);
+    if (!common) common = first_common_hit(network, directions, ghost_starts);
+
+    if (common && *common <= static_cast<Wide>(never - 1)) std::printf("all %llu\n", static_cast<unsigned long long>(*common));
+    else std::printf("all -\n");
+  }
+
+  return EXIT_SUCCESS;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  if (argc > 2) return d8::answer_queries(argv[1], argv[2]);
+  return aoc::solver_main(argc, argv, d8::solve);
 }
+#endif
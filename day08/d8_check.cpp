@@ -0,0 +1,189 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "d8_walk.h"
+
+// Checks PassTable's lifted walks, and the grouped walker, against stepping through the
+// network one node at a time, on lots of small random networks. Prints the first mismatch
+// and fails if there is one.
+
+namespace
+{
+
+std::mt19937_64 rng(2023);
+
+std::uint64_t uniform(std::uint64_t lo, std::uint64_t hi)
+{
+  return std::uniform_int_distribution<std::uint64_t>(lo, hi)(rng);
+}
+
+struct Case
+{
+  d8::Network network;
+  std::vector<std::uint8_t> directions;
+};
+
+Case random_case()
+{
+  Case c;
+  const std::uint32_t num_nodes = uniform(1, 60);
+  c.directions.resize(uniform(1, 9));
+  for (std::uint8_t& d : c.directions) d = uniform(0, 1);
+
+  c.network.left.resize(num_nodes);
+  c.network.right.resize(num_nodes);
+  c.network.ends_with_z.resize(num_nodes);
+  for (std::uint32_t n = 0; n < num_nodes; n++)
+  {
+    c.network.left[n] = uniform(0, num_nodes - 1);
+    c.network.right[n] = uniform(0, num_nodes - 1);
+    c.network.ends_with_z[n] = uniform(0, 9) == 0;
+  }
+
+  return c;
+}
+
+std::uint32_t naive_position(const Case& c, std::uint32_t node, std::uint64_t steps)
+{
+  for (std::uint64_t i = 0; i < steps; i++)
+  {
+    node = c.directions[i % c.directions.size()] ? c.network.right[node] : c.network.left[node];
+  }
+  return node;
+}
+
+std::uint64_t naive_first_hit(const Case& c, std::uint32_t node, std::uint64_t max_steps)
+{
+  const std::uint64_t limit = std::min<std::uint64_t>(max_steps, c.network.left.size() * c.directions.size());
+  for (std::uint64_t i = 0; i <= limit; i++)
+  {
+    if (c.network.ends_with_z[node]) return i;
+    node = c.directions[i % c.directions.size()] ? c.network.right[node] : c.network.left[node];
+  }
+  return d8::never;
+}
+
+// As far as a single walk goes before it gives up.
+std::uint64_t walk_cap(const Case& c)
+{
+  return c.network.left.size() * c.directions.size();
+}
+
+bool fail(const char* what, int round, std::uint32_t start, std::uint64_t steps, std::uint64_t got, std::uint64_t expected)
+{
+  std::fprintf(
+    stderr,
+    "%s mismatch in round %d from node %u after %llu steps: got %llu, expected %llu\n",
+    what,
+    round,
+    start,
+    static_cast<unsigned long long>(steps),
+    static_cast<unsigned long long>(got),
+    static_cast<unsigned long long>(expected));
+  return false;
+}
+
+bool check_round(int round)
+{
+  const Case c = random_case();
+  const std::uint32_t num_nodes = c.network.left.size();
+
+  // Tables covering anything from one pass to more than any walk here, so that walks also
+  // have to go round the top level several times.
+  const std::uint64_t table_steps = uniform(0, 1) ? uniform(0, 64) : uniform(0, 5000);
+  const d8::PassTable passes(c.network, c.directions, c.network.ends_with_z, table_steps);
+
+  constexpr std::size_t num_walks = 32;
+  std::vector<std::uint32_t> starts(num_walks);
+  std::vector<std::uint64_t> steps(num_walks);
+  for (std::size_t i = 0; i < num_walks; i++)
+  {
+    starts[i] = uniform(0, num_nodes - 1);
+    steps[i] = uniform(0, 3) ? uniform(0, 3000) : uniform(0, 20);
+  }
+
+  std::vector<std::uint32_t> nodes(num_walks);
+  std::vector<std::uint64_t> hits(num_walks);
+  passes.position(starts.data(), steps.data(), num_walks, nodes.data());
+  passes.first_hit(starts.data(), steps.data(), num_walks, hits.data());
+
+  for (std::size_t i = 0; i < num_walks; i++)
+  {
+    const std::uint32_t expected_node = naive_position(c, starts[i], steps[i]);
+    if (nodes[i] != expected_node) return fail("position", round, starts[i], steps[i], nodes[i], expected_node);
+    if (passes.position(starts[i], steps[i]) != expected_node)
+    {
+      return fail("single position", round, starts[i], steps[i], passes.position(starts[i], steps[i]), expected_node);
+    }
+
+    const std::uint64_t expected_hit = naive_first_hit(c, starts[i], steps[i]);
+    if (hits[i] != expected_hit) return fail("first hit", round, starts[i], steps[i], hits[i], expected_hit);
+    if (passes.first_hit(starts[i], steps[i]) != expected_hit)
+    {
+      return fail("single first hit", round, starts[i], steps[i], passes.first_hit(starts[i], steps[i]), expected_hit);
+    }
+  }
+
+  // Far too many steps to take one at a time, but a walk that far is wherever the same
+  // walk is a whole number of passes earlier, then the rest of the way.
+  for (std::size_t i = 0; i < num_walks; i++)
+  {
+    const std::uint64_t far = uniform(std::uint64_t(1) << 40, std::uint64_t(1) << 62);
+    const std::uint64_t split = far / c.directions.size() / 2 * c.directions.size();
+    const std::uint32_t expected = passes.position(passes.position(starts[i], split), far - split);
+    const std::uint32_t got = passes.position(starts[i], far);
+    if (got != expected) return fail("far position", round, starts[i], far, got, expected);
+
+    const std::uint64_t expected_hit = naive_first_hit(c, starts[i], far);
+    const std::uint64_t hit = passes.first_hit(starts[i], far);
+    if (hit != expected_hit) return fail("far first hit", round, starts[i], far, hit, expected_hit);
+  }
+
+  // The walker, with starts for several groups, against one walk at a time.
+  const auto on_z = [&c] (std::uint32_t node) { return c.network.ends_with_z[node] != 0; };
+  std::vector<std::uint64_t> walked(num_walks);
+  nodes = starts;
+  d8::steps_to_reach_targets(c.network, c.directions, on_z, 0, walk_cap(c), nodes.data(), walked.data(), num_walks);
+  for (std::size_t i = 0; i < num_walks; i++)
+  {
+    const std::uint64_t expected = d8::steps_to_reach_target(c.network, starts[i], c.directions, on_z);
+    if (walked[i] != expected) return fail("walker", round, starts[i], walk_cap(c), walked[i], expected);
+    if (expected != d8::never && nodes[i] != naive_position(c, starts[i], expected))
+    {
+      return fail("walker end", round, starts[i], expected, nodes[i], naive_position(c, starts[i], expected));
+    }
+  }
+
+  // Leaving the start behind, and giving up early.
+  const std::uint64_t max_steps = uniform(0, 100);
+  nodes = starts;
+  d8::steps_to_reach_targets(c.network, c.directions, on_z, 1, max_steps, nodes.data(), walked.data(), num_walks);
+  for (std::size_t i = 0; i < num_walks; i++)
+  {
+    std::uint64_t expected = d8::never;
+    for (std::uint64_t s = 1; s <= max_steps && expected == d8::never; s++)
+    {
+      if (on_z(naive_position(c, starts[i], s))) expected = s;
+    }
+    if (walked[i] != expected) return fail("walker from step 1", round, starts[i], max_steps, walked[i], expected);
+  }
+
+  return true;
+}
+
+}
+
+int main()
+{
+  constexpr int num_rounds = 2000;
+  for (int round = 0; round < num_rounds; round++)
+  {
+    if (!check_round(round)) return EXIT_FAILURE;
+  }
+
+  std::printf("%d rounds OK\n", num_rounds);
+  return EXIT_SUCCESS;
+}
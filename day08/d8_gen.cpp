@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "generate.h"
+
+// Generates a network shaped like the real one.
+//
+// Each ghost walks a loop of p layers (p prime) where every layer is a pair of nodes, and
+// both nodes of a layer lead to the pair in the next layer. The only way onto the ..Z node
+// at the end of the loop is a "funnel" which demands that the last few instructions match
+// the tail of the direction string. So the first ..Z hit is after exactly p * D steps (where
+// D is the prime number of directions) and it recurs cleanly from there, which is the
+// property the real inputs have.
+//
+// Scaling grows the number of layers per ghost (there are always six ghosts).
+
+constexpr std::size_t num_ghosts = 6;
+constexpr std::size_t num_directions = 293;
+constexpr std::size_t funnel_length = 12;
+
+bool is_prime(std::size_t n) {
+  if (n < 2) return false;
+  for (std::size_t d = 2; d * d <= n; d++) {
+    if (n % d == 0) return false;
+  }
+  return true;
+}
+
+// Does the last `len` characters of `s` occur anywhere else in `s` (treated as cyclic)?
+bool suffix_repeats(const std::string& s, std::size_t len) {
+  const std::string doubled = s + s;
+  const std::string suffix = s.substr(s.size() - len);
+  for (std::size_t i = 0; i + 1 < s.size(); i++) {
+    if (doubled.compare(i + s.size() - len + 1, len, suffix) == 0) return true;
+  }
+  return false;
+}
+
+struct Node {
+  std::string label;
+  int left;
+  int right;
+};
+
+int main(int argc, char** argv) {
+  auto [scale, rng] = aoc::parse_generator_args(argc, argv);
+
+  // Pick the layer counts: distinct primes around 60 * scale.
+  const auto target_layers = std::max<std::size_t>(funnel_length + 3, std::lround(60 * scale));
+  std::set<std::size_t> layer_counts;
+  while (layer_counts.size() < num_ghosts) {
+    auto p = aoc::uniform<std::size_t>(rng, target_layers, target_layers + target_layers / 3 + 20);
+    while (!is_prime(p) || p == num_directions) ++p;
+    layer_counts.insert(p);
+  }
+
+  // Directions whose tail (which every funnel keys off) appears nowhere else.
+  std::string directions(num_directions, 'L');
+  do {
+    for (auto& c : directions) c = aoc::uniform(rng, 0, 1) ? 'L' : 'R';
+  } while (suffix_repeats(directions, funnel_length + 1));
+
+  // Labels: stick with upper case letters like the real input unless we'll run out.
+  std::size_t num_nodes = 0;
+  for (auto p : layer_counts) num_nodes += 2 * p;
+  const std::string alphabet = num_nodes < 26 * 26 * 20
+    ? "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+    : "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+  std::vector<std::string> starts, ends, others;
+  for (char a : alphabet) {
+    for (char b : alphabet) {
+      for (char c : alphabet) {
+        const std::string label{a, b, c};
+        if (label == "AAA" || label == "ZZZ") continue;
+        if (c == 'A') starts.push_back(label);
+        else if (c == 'Z') ends.push_back(label);
+        else others.push_back(label);
+      }
+    }
+  }
+
+  if (others.size() < num_nodes) {
+    std::fprintf(stderr, "Scale too large: not enough three character labels\n");
+    return EXIT_FAILURE;
+  }
+
+  std::shuffle(starts.begin(), starts.end(), rng);
+  std::shuffle(ends.begin(), ends.end(), rng);
+  std::shuffle(others.begin(), others.end(), rng);
+
+  std::vector<Node> nodes;
+  const auto add_node = [&nodes] (std::string label) {
+    nodes.push_back(Node{std::move(label), -1, -1});
+    return static_cast<int>(nodes.size() - 1);
+  };
+
+  std::size_t ghost = 0;
+  for (const auto p : layer_counts) {
+    // Layer 0 is the start node, layer p is the ..Z node alongside a regular node.
+    // Layers 1 to m are plain pairs and the funnel runs from layer m to p.
+    const std::size_t m = p - funnel_length;
+    const int start = add_node(ghost == 0 ? "AAA" : starts[ghost]);
+
+    std::vector<std::pair<int, int>> layers(p + 1);
+    layers[0] = {start, start};
+    for (std::size_t i = 1; i < p; i++) {
+      layers[i] = {add_node(others.back()), -1};
+      others.pop_back();
+      layers[i].second = add_node(others.back());
+      others.pop_back();
+    }
+    layers[p] = {add_node(ghost == 0 ? "ZZZ" : ends[ghost]), add_node(others.back())};
+    others.pop_back();
+
+    // The plain layers: both nodes of a layer share an orientation. The orientation into
+    // layer m is forced so that the first letter of the funnel key lands on its first node.
+    const std::size_t key_start = num_directions - funnel_length - 1;
+    for (std::size_t i = 0; i < m; i++) {
+      bool swapped = aoc::uniform(rng, 0, 1);
+      if (i + 1 == m) swapped = directions[key_start] == 'R';
+
+      const auto [x, y] = layers[i + 1];
+      for (int n : {layers[i].first, layers[i].second}) {
+        nodes[n].left = swapped ? y : x;
+        nodes[n].right = swapped ? x : y;
+      }
+    }
+
+    // The funnel: the first node of each layer stays on the key path only if the next
+    // instruction matches the key, everything else drains into the second nodes.
+    for (std::size_t i = m; i < p; i++) {
+      const auto [on_key, off_key] = layers[i + 1];
+      const char key = directions[key_start + 1 + i - m];
+      nodes[layers[i].first].left = key == 'L' ? on_key : off_key;
+      nodes[layers[i].first].right = key == 'R' ? on_key : off_key;
+      nodes[layers[i].second].left = off_key;
+      nodes[layers[i].second].right = off_key;
+    }
+
+    // Both end nodes loop back round to layer 1 just like the start node.
+    for (int n : {layers[p].first, layers[p].second}) {
+      nodes[n].left = nodes[start].left;
+      nodes[n].right = nodes[start].right;
+    }
+
+    ++ghost;
+  }
+
+  std::vector<std::size_t> order(nodes.size());
+  for (std::size_t i = 0; i < order.size(); i++) order[i] = i;
+  std::shuffle(order.begin(), order.end(), rng);
+
+  std::printf("%s\n\n", directions.c_str());
+  for (auto i : order) {
+    const auto& n = nodes[i];
+    std::printf("%s = (%s, %s)\n", n.label.c_str(), nodes[n.left].label.c_str(), nodes[n.right].label.c_str());
+  }
+}
@@ -0,0 +1,353 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "work_stealing.h"
+
+namespace d8
+{
+
+// The network with nodes numbered densely, so each link is just an index into left/right.
+struct Network
+{
+  std::vector<std::uint32_t> left;
+  std::vector<std::uint32_t> right;
+  std::vector<std::uint8_t> ends_with_z;
+  std::vector<std::uint32_t> ends_with_a;
+};
+
+// The step count for a walk that doesn't get where it's going.
+constexpr std::uint64_t never = ~std::uint64_t(0);
+
+// Every walk starts at the beginning of the directions, so after each whole pass through
+// them it's back at the beginning. This has where a walk from each node is after one pass,
+// and where in the pass it first reaches a target, so walks can go a pass at a time.
+//
+// On top of that it can answer "where is a walk after N steps" and "when does it first
+// reach a target" in O(log N) rather than N steps: (binary lifting) it also has where each
+// node ends up after 2, 4, 8, ... passes, each entry flagged if the walk goes past a target
+// on the way.
+class PassTable
+{
+public:
+  // Enough levels that walks of up to max_steps only need to use each level once at most,
+  // as long as they fit in max_table_bytes. Longer walks take the top level as many times
+  // as they need to, up to the `nodes` passes it takes any walk to start repeating itself.
+  PassTable(
+    const Network& network,
+    const std::vector<std::uint8_t>& directions,
+    const std::vector<std::uint8_t>& targets,
+    std::uint64_t max_steps = 0)
+    : next_{network.left.data(), network.right.data()}, directions_(directions), targets_(targets)
+  {
+    const std::size_t num_nodes = network.left.size();
+    const std::uint32_t pass = directions.size();
+
+    // Nodes take their pass together, a block at a time, one direction at a time, so the
+    // loads are all independent of each other rather than one long chain per node.
+    std::vector<std::uint32_t> after_pass(num_nodes);
+    first_target_.assign(num_nodes, pass);
+    const std::size_t num_blocks = (num_nodes + block_size - 1) / block_size;
+    aoc::parallel_for(num_blocks, [this, &after_pass, &directions, &targets, num_nodes, pass] (std::size_t b)
+    {
+      const std::uint32_t begin = b * block_size;
+      const std::uint32_t end = std::min<std::size_t>(num_nodes, begin + block_size);
+      for (std::uint32_t n = begin; n < end; n++) after_pass[n] = n;
+      for (std::uint32_t i = 0; i < pass; i++)
+      {
+        const std::uint32_t* next = next_[directions[i]];
+        for (std::uint32_t n = begin; n < end; n++)
+        {
+          if (first_target_[n] == pass && targets[after_pass[n]]) first_target_[n] = i;
+          after_pass[n] = next[after_pass[n]];
+        }
+      }
+
+      for (std::uint32_t n = begin; n < end; n++)
+      {
+        if (first_target_[n] < pass) after_pass[n] |= hit_flag;
+      }
+    });
+    levels_.push_back(std::move(after_pass));
+
+    const std::size_t max_levels = std::max<std::size_t>(1, max_table_bytes / (num_nodes * sizeof(std::uint32_t) + 1));
+    const std::uint64_t max_passes = max_steps / pass;
+    while (levels_.size() < std::min<std::size_t>(max_levels, 64) && max_passes >> levels_.size())
+    {
+      // 2^(k+1) passes are 2^k passes twice over.
+      const std::vector<std::uint32_t>& half = levels_.back();
+      std::vector<std::uint32_t> doubled(num_nodes);
+      aoc::parallel_for(num_blocks, [&half, &doubled, num_nodes] (std::size_t b)
+      {
+        const std::size_t end = std::min(num_nodes, (b + 1) * block_size);
+        for (std::size_t n = b * block_size; n < end; n++)
+        {
+          const std::uint32_t mid = half[n];
+          doubled[n] = half[mid & node_mask] | (mid & hit_flag);
+        }
+      });
+      levels_.push_back(std::move(doubled));
+    }
+  }
+
+  std::uint32_t pass_length() const { return directions_.size(); }
+
+  // Where a walk from the node is after one pass through the directions.
+  std::uint32_t after_pass(std::uint32_t node) const { return levels_[0][node] & node_mask; }
+
+  // Calls f(i) for each step i of one pass from the node that's on a target.
+  template<typename F>
+  void for_each_hit(std::uint32_t node, F f) const
+  {
+    for (std::uint32_t i = first_target_[node] == pass_length() ? pass_length() : 0; i < pass_length(); i++)
+    {
+      if (targets_[node]) f(i);
+      node = next_[directions_[i]][node];
+    }
+  }
+
+  // Where a walk from the node is after the given number of steps.
+  std::uint32_t position(std::uint32_t start, std::uint64_t steps) const
+  {
+    std::uint32_t node;
+    position(&start, &steps, 1, &node);
+    return node;
+  }
+
+  // The same for many walks at once: nodes[i] is where the walk from starts[i] is after
+  // steps[i] steps. Going through a level for all of them at a time keeps plenty of
+  // independent loads in flight.
+  void position(const std::uint32_t* starts, const std::uint64_t* steps, std::size_t n, std::uint32_t* nodes) const
+  {
+    const std::size_t top = levels_.size() - 1;
+    const std::uint64_t num_nodes = levels_[0].size();
+    std::vector<std::uint64_t> passes(n);
+    for (std::size_t j = 0; j < n; j++)
+    {
+      nodes[j] = starts[j];
+      passes[j] = steps[j] / pass_length();
+      if (passes[j] >> top > 1 && passes[j] > num_nodes)
+      {
+        // Further than the levels reach. Within `nodes` passes the walk is going round a
+        // cycle of pass starts, so from there it only needs to go what's left over of the
+        // way round that.
+        nodes[j] = jump(nodes[j], num_nodes);
+        std::uint64_t length = 1;
+        for (std::uint32_t node = after_pass(nodes[j]); node != nodes[j]; node = after_pass(node)) ++length;
+        passes[j] = (passes[j] - num_nodes) % length;
+      }
+      for (; passes[j] >> top > 1; passes[j] -= std::uint64_t(1) << top)
+      {
+        nodes[j] = levels_[top][nodes[j]] & node_mask;
+      }
+    }
+
+    for (std::size_t k = 0; k <= top; k++)
+    {
+      const std::vector<std::uint32_t>& level = levels_[k];
+      for (std::size_t j = 0; j < n; j++)
+      {
+        if (passes[j] >> k & 1) nodes[j] = level[nodes[j]] & node_mask;
+      }
+    }
+
+    for (std::size_t j = 0; j < n; j++)
+    {
+      for (std::uint32_t i = 0; i < steps[j] % pass_length(); i++) nodes[j] = next_[directions_[i]][nodes[j]];
+    }
+  }
+
+  // The first step (counting the start as step 0) at which a walk from the node is on a
+  // target, or `never` if it isn't within max_steps.
+  std::uint64_t first_hit(std::uint32_t start, std::uint64_t max_steps) const
+  {
+    std::uint64_t steps;
+    first_hit(&start, &max_steps, 1, &steps);
+    return steps;
+  }
+
+  // The same for many walks at once, each with its own window.
+  void first_hit(const std::uint32_t* starts, const std::uint64_t* max_steps, std::size_t n, std::uint64_t* steps) const
+  {
+    const std::size_t top = levels_.size() - 1;
+    std::vector<std::uint32_t> nodes(starts, starts + n);
+    std::vector<std::uint64_t> passes(n, 0);
+    std::vector<std::uint64_t> max_passes(n);
+
+    // Skip as many passes without a target as possible, biggest jumps first. Beyond what
+    // the table covers, that's the top level as many times as it takes. A walk is back at
+    // a pass start it's been at before within `nodes` passes, so there's no need to look
+    // any further than that.
+    for (std::size_t j = 0; j < n; j++)
+    {
+      max_passes[j] = std::min<std::uint64_t>(max_steps[j] / pass_length(), levels_[0].size());
+      while (passes[j] <= max_passes[j] && !(levels_[top][nodes[j]] & hit_flag))
+      {
+        nodes[j] = levels_[top][nodes[j]];
+        passes[j] += std::uint64_t(1) << top;
+      }
+    }
+
+    for (std::size_t k = top + 1; k-- > 0;)
+    {
+      const std::vector<std::uint32_t>& level = levels_[k];
+      for (std::size_t j = 0; j < n; j++)
+      {
+        const std::uint32_t entry = level[nodes[j]];
+        if (!(entry & hit_flag))
+        {
+          nodes[j] = entry;
+          passes[j] += std::uint64_t(1) << k;
+        }
+      }
+    }
+
+    // Each walk is now on the pass with its first target in it (if it's anywhere).
+    for (std::size_t j = 0; j < n; j++)
+    {
+      const std::uint32_t offset = first_target_[nodes[j]];
+      steps[j] = never;
+      if (offset < pass_length() && passes[j] <= max_passes[j])
+      {
+        const std::uint64_t hit = passes[j] * pass_length() + offset;
+        if (hit <= max_steps[j]) steps[j] = hit;
+      }
+    }
+  }
+
+private:
+  // Node ids fit in 31 bits (labels are at most 36^3), leaving the top one for the flag.
+  static constexpr std::uint32_t hit_flag = 1u << 31;
+  static constexpr std::uint32_t node_mask = hit_flag - 1;
+
+  // Nodes per pool task when building the table.
+  static constexpr std::size_t block_size = 4096;
+
+  // The most the levels can take up between them.
+  static constexpr std::size_t max_table_bytes = std::size_t(1) << 28;
+
+  const std::uint32_t* next_[2];
+  const std::vector<std::uint8_t>& directions_;
+  const std::vector<std::uint8_t>& targets_;
+
+  std::vector<std::uint32_t> first_target_;
+  std::vector<std::vector<std::uint32_t>> levels_;
+
+  // Where a walk from the node is after the given number of passes.
+  std::uint32_t jump(std::uint32_t node, std::uint64_t passes) const
+  {
+    const std::size_t top = levels_.size() - 1;
+    for (; passes >> top > 1; passes -= std::uint64_t(1) << top) node = levels_[top][node] & node_mask;
+    for (std::size_t k = 0; k <= top; k++)
+    {
+      if (passes >> k & 1) node = levels_[k][node] & node_mask;
+    }
+    return node;
+  }
+};
+
+// How many steps a walk from the start takes until stop(node) holds. `never` if it doesn't,
+// which is clear after (nodes * directions) steps as by then the walk is going round in
+// circles.
+template<typename Stop>
+std::uint64_t steps_to_reach_target(
+  const Network& network,
+  std::uint32_t start,
+  const std::vector<std::uint8_t>& directions,
+  Stop stop)
+{
+  const std::uint32_t* next[2] = {network.left.data(), network.right.data()};
+  const std::uint64_t max_steps = network.left.size() * directions.size();
+
+  std::size_t index = 0;
+  std::uint32_t current = start;
+  for (std::uint64_t num_steps = 0; num_steps <= max_steps; num_steps++)
+  {
+    if (stop(current)) return num_steps;
+    current = next[directions[index]][current];
+    if (++index == directions.size()) index = 0;
+  }
+
+  return never;
+}
+
+// Walks from each of nodes[0..n) until stop(node) holds, but only counting nodes from
+// min_steps steps on (so with min_steps 1 a walk can leave a node it should stop at). Leaves
+// nodes[i] where that walk stopped and steps[i] how many steps it took, or `never` if it
+// hadn't stopped after max_steps.
+//
+// The walks are shared out between pool tasks in groups, and each task takes its group a
+// step at a time in lockstep, so that while one walk waits on its load the others' are
+// already in flight. The load a walk needs next is known as soon as it has moved, so that
+// gets prefetched straight away.
+template<typename Stop>
+void steps_to_reach_targets(
+  const Network& network,
+  const std::vector<std::uint8_t>& directions,
+  Stop stop,
+  std::uint64_t min_steps,
+  std::uint64_t max_steps,
+  std::uint32_t* nodes,
+  std::uint64_t* steps,
+  std::size_t n)
+{
+  static constexpr std::size_t group_size = 8;
+
+  const std::uint32_t* next[2] = {network.left.data(), network.right.data()};
+
+  const std::size_t num_groups = (n + group_size - 1) / group_size;
+  aoc::parallel_for(num_groups, [&next, &directions, &stop, min_steps, max_steps, nodes, steps, n] (std::size_t g)
+  {
+    // The walks still going, packed at the front.
+    std::uint32_t current[group_size];
+    std::size_t walk[group_size];
+    std::size_t num_walking = 0;
+    for (std::size_t i = g * group_size; i < std::min(n, (g + 1) * group_size); i++)
+    {
+      if (min_steps == 0 && stop(nodes[i]))
+      {
+        steps[i] = 0;
+        continue;
+      }
+      current[num_walking] = nodes[i];
+      walk[num_walking++] = i;
+    }
+
+    std::size_t index = 0;
+    for (std::uint64_t s = 1; num_walking > 0 && s <= max_steps; s++)
+    {
+      const std::uint32_t* step = next[directions[index]];
+      if (++index == directions.size()) index = 0;
+      const std::uint32_t* following = next[directions[index]];
+
+      for (std::size_t w = 0; w < num_walking;)
+      {
+        current[w] = step[current[w]];
+        if (s >= min_steps && stop(current[w]))
+        {
+          // Swap the last walk (which hasn't taken this step yet) into its place.
+          nodes[walk[w]] = current[w];
+          steps[walk[w]] = s;
+          --num_walking;
+          current[w] = current[num_walking];
+          walk[w] = walk[num_walking];
+        }
+        else
+        {
+          __builtin_prefetch(&following[current[w]]);
+          ++w;
+        }
+      }
+    }
+
+    for (std::size_t w = 0; w < num_walking; w++)
+    {
+      nodes[walk[w]] = current[w];
+      steps[walk[w]] = never;
+    }
+  });
+}
+
+}
@@ -1,138 +1,172 @@
+#include <algorithm>
 #include <array>
-#include <cassert>
-#include <fstream>
-#include <iostream>
+#include <cstdint>
 #include <limits>
-#include <queue>
-#include <string>
+#include <string_view>
 #include <vector>
 
+#include "counters.h"
+#include "grid.h"
+#include "input.h"
+#include "phase.h"
+#include "solver.h"
+#include "work_stealing.h"
+
+namespace d17 {
+
 enum Direction : std::uint8_t { N, E, S, W };
 
-constexpr std::array<Direction, 4> inverse = { S, W, N, E };
+// Which way a crucible was going when it got somewhere. Whichever way along that line it
+// was going, it has to turn next, and the two turns are the same either way, so N and S
+// (or E and W) don't need telling apart.
+enum Axis : std::uint8_t { NorthSouth, EastWest };
 
-constexpr std::array<std::pair<int, int>, 4> offsets = {
-  std::make_pair(0, -1),
-  std::make_pair(1, 0),
-  std::make_pair(0, 1),
-  std::make_pair(-1, 0)
-};
+constexpr std::array<std::array<Direction, 2>, 2> turns = {{ {E, W}, {N, S} }};
 
 struct Location {
-  std::int16_t x;
-  std::int16_t y;
-  std::uint16_t cost;
-  Direction last_dir;
-  std::uint8_t steps_in_dir;
+  aoc::Grid::Index pos;
+  std::uint32_t cost;
+  Axis axis;
 };
 
-// Comparison operator designed such that the top element of the priority queue will have the
-// lowest cost (consider cheap locations first).
-bool operator<(const Location& loc1, const Location& loc2) {
-  return loc1.cost > loc2.cost;
-}
+// The priority queue for the search. No step of the search costs more than max_step, so
+// everything waiting in the queue is within max_step of the cheapest thing in it (Dijkstra
+// never pushes anything cheaper than what it last popped). So instead of a heap it's a ring
+// of max_step + 1 buckets, one per cost (Dial's algorithm), and push and pop are O(1).
+// Entries of equal cost come out in any order.
+template<typename T, std::size_t max_step>
+class BucketQueue {
+public:
+  void push(const T& t) {
+    buckets_[t.cost % num_buckets].push_back(t);
+    ++size_;
+  }
+
+  bool empty() const { return size_ == 0; }
+
+  // The cheapest entry. Not const, as this is where the queue catches up with its contents.
+  const T& top() {
+    while (buckets_[current_].empty()) current_ = current_ + 1 == num_buckets ? 0 : current_ + 1;
+    return buckets_[current_].back();
+  }
+
+  void pop() {
+    top();
+    buckets_[current_].pop_back();
+    --size_;
+  }
+
+private:
+  static constexpr std::size_t num_buckets = max_step + 1;
+
+  std::array<std::vector<T>, num_buckets> buckets_;
+  std::size_t current_ = 0;
+  std::size_t size_ = 0;
+};
 
 class Map {
 public:
-  Map(const std::vector<std::string>& grid)
-    : width_(grid.size()), height_(grid[0].size()), grid_(grid) {}
+  // The border is '#' (i.e. not a digit) so steps off the map can be spotted.
+  Map(const std::vector<std::string_view>& grid)
+    : grid_(grid, '#') {}
 
   template<std::uint8_t direction_min, std::uint8_t direction_max>
-  int find_min_path_cost() const;
+  std::uint32_t find_min_path_cost() const;
 
 private:
-  std::size_t width_;
-  std::size_t height_;
-  std::vector<std::string> grid_;
+  aoc::Grid grid_;
 };
 
 template<std::uint8_t direction_min, std::uint8_t direction_max>
-int Map::find_min_path_cost() const {
-  // Maintain a prioritised queue of locations to consider next.
-  std::priority_queue<Location> todo;
-  todo.push(Location{0, 0, 0, N, 0});
-
-  // Costs for each location.
-  // Need to take into account the incoming directions: it could be that we reach a location
-  // faster, but because we were already heading in a specific direction we've clobbered our
-  // prospects for the rest of the path.
-  constexpr std::size_t required_hash = direction_max * 4;
-  std::vector<std::vector<std::array<int, required_hash>>> lowest_costs;
-  lowest_costs.reserve(height_);
-  for (std::size_t i = 0; i < height_; i++) {
-    lowest_costs.push_back(std::vector<std::array<int, required_hash>>());
-    lowest_costs.back().reserve(width_);
-    for (std::size_t j = 0; j < width_; j++) {
-      std::array<int, required_hash> incoming_dir_costs;
-      incoming_dir_costs.fill(std::numeric_limits<int>::max());
-      lowest_costs[i].push_back(incoming_dir_costs);
-    }
+std::uint32_t Map::find_min_path_cost() const {
+  // Every move is a turn followed by a straight run of direction_min to direction_max
+  // blocks, taken as one step of the search. So the state is just where the crucible is and
+  // which axis it was moving along, and how far it's been going never needs tracking.
+  constexpr std::uint8_t min_run = std::max<std::uint8_t>(direction_min, 1);
+
+  const auto start = grid_.index(0, 0);
+  const auto end = grid_.index(grid_.width() - 1, grid_.height() - 1);
+
+  // Lowest cost so far for each state: two per location, indexed the same way as the grid
+  // (so the border gets slots too, they're just never used).
+  constexpr std::uint32_t unreached = std::numeric_limits<std::uint32_t>::max();
+  std::vector<std::uint32_t> lowest_costs(2 * grid_.size(), unreached);
+  const auto state = [] (aoc::Grid::Index pos, Axis axis) { return 2 * std::size_t(pos) + axis; };
+
+  // A run costs at most 9 per block.
+  BucketQueue<Location, 9 * direction_max> todo;
+  for (const Axis axis : {NorthSouth, EastWest}) {
+    lowest_costs[state(start, axis)] = 0;
+    todo.push(Location{start, 0, axis});
   }
 
+  aoc::PerfCounters counters("find_min_path_cost");
   while (!todo.empty()) {
     const auto loc = todo.top();
     todo.pop();
 
-    const bool is_start = loc.x == 0 && loc.y == 0;
-
-    // Generate the neighbours with their costs.
-    for (const auto d : {N, E, S, W}) {
-      // Will this move run afoul of the N steps in same direction limit?
-      if (d == loc.last_dir && loc.steps_in_dir == direction_max) continue;
-
-      // Impose minimum movement limit.
-      if (!is_start && d != loc.last_dir && loc.steps_in_dir < direction_min) continue;
-
-      // Prevent going backwards.
-      if (!is_start && d == inverse[loc.last_dir]) continue;
-
-      const auto& offset = offsets[d];
-
-      // Will this step be on the grid?
-      const std::int16_t next_x = loc.x + offset.first;
-      const std::int16_t next_y = loc.y + offset.second;
-      if (next_x < 0 ||
-          next_x >= static_cast<int>(width_) ||
-          next_y < 0 ||
-          next_y >= static_cast<int>(height_)) continue;
-
-      std::uint8_t next_step_count = 1;
-      if (d == loc.last_dir) next_step_count = loc.steps_in_dir + 1;
-      assert(next_step_count <= direction_max);
-
-      // Have we already reached this loc by a shorter path?
-      const std::uint16_t next_cost = loc.cost + grid_[next_y][next_x] - '0';
-      const int incoming_dir_hash = direction_max * d + next_step_count - 1;
-      if (lowest_costs[next_y][next_x][incoming_dir_hash] <= next_cost) continue;
-
-      // Worth considering.
-      lowest_costs[next_y][next_x][incoming_dir_hash] = next_cost;
-      todo.push(Location{next_x, next_y, next_cost, d, next_step_count});
+    // Already got here some cheaper way since this was queued.
+    if (lowest_costs[state(loc.pos, loc.axis)] < loc.cost) continue;
+    if (loc.pos == end) break;
+
+    const Axis next_axis = loc.axis == NorthSouth ? EastWest : NorthSouth;
+    for (const Direction d : turns[loc.axis]) {
+      aoc::Grid::Index next = loc.pos;
+      std::uint32_t next_cost = loc.cost;
+      for (std::uint8_t run = 1; run <= direction_max; run++) {
+        // Will this step be on the grid?
+        next += grid_.offsets()[d];
+        if (grid_[next] == '#') break;
+
+        next_cost += grid_[next] - '0';
+        if (run < min_run) continue;
+
+        // Have we already reached this state by a shorter path?
+        std::uint32_t& lowest = lowest_costs[state(next, next_axis)];
+        if (lowest <= next_cost) continue;
+
+        // Worth considering.
+        lowest = next_cost;
+        todo.push(Location{next, next_cost, next_axis});
+      }
     }
   }
+  counters.stop();
 
-  // Find the actual lowest.
-  int lowest = std::numeric_limits<int>::max();
-  for (int val : lowest_costs.back().back()) {
-    lowest = std::min(lowest, val);
-  }
-
-  return lowest;
+  return std::min(lowest_costs[state(end, NorthSouth)], lowest_costs[state(end, EastWest)]);
 }
 
-int main() {
-  std::ifstream fs("input.txt");
-  std::vector<std::string> grid;
-  std::string line;
-  while (std::getline(fs, line)) {
+aoc::Answer solve(std::string_view input) {
+  aoc::PhaseTimer timer("parse");
+
+  std::vector<std::string_view> grid;
+  for (std::string_view line : aoc::Lines(input)) {
     grid.push_back(line);
   }
 
   Map m(grid);
 
-  const int cost_p1 = m.find_min_path_cost<0, 3>();
-  const int cost_p2 = m.find_min_path_cost<4, 10>();
-  std::cout << "P1: " << cost_p1 << ", P2: " << cost_p2 << std::endl;
+  timer.stop();
+
+  // The two parts only share the (read only) map so they can run side by side.
+  std::uint32_t cost_p1, cost_p2;
+  aoc::parallel_invoke(
+    [&] {
+      aoc::PhaseTimer phase("P1", aoc::PhaseScope::Thread);
+      cost_p1 = m.find_min_path_cost<0, 3>();
+    },
+    [&] {
+      aoc::PhaseTimer phase("P2", aoc::PhaseScope::Thread);
+      cost_p2 = m.find_min_path_cost<4, 10>();
+    });
+
+  return {cost_p1, cost_p2};
+}
+
+}
 
-  return 0;
+#ifndef AOC_LIBRARY
+int main(int argc, char** argv) {
+  return aoc::solver_main(argc, argv, d17::solve);
 }
+#endif
@@ -0,0 +1,30 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+#include "generate.h"
+
+// Generates a square heat loss map like the real one (141 x 141 digits from 1 to 9, with
+// the losses generally higher towards the middle of the map).
+// Scaling grows the number of cells, so the side grows with the square root of the scale.
+
+int main(int argc, char** argv) {
+  auto [scale, rng] = aoc::parse_generator_args(argc, argv);
+
+  const long side = std::max(2L, std::lround(141 * std::sqrt(scale)));
+  const double centre = 0.5 * (side - 1);
+
+  std::string row(side, ' ');
+  for (long y = 0; y < side; y++) {
+    for (long x = 0; x < side; x++) {
+      // Distance from the centre, normalised so the corners are at 1.
+      const double d = std::hypot(x - centre, y - centre) / std::hypot(centre, centre);
+      const long base = std::lround(8 - 5 * d);
+      row[x] = '0' + std::clamp(base + aoc::uniform(rng, -2L, 2L), 1L, 9L);
+    }
+
+    std::fwrite(row.data(), 1, row.size(), stdout);
+    std::putchar('\n');
+  }
+}
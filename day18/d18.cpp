@@ -1,14 +1,18 @@
 #include <array>
-#include <fstream>
-#include <iostream>
-#include <string>
-#include <sstream>
+#include <string_view>
 #include <vector>
 
+#include "input.h"
+#include "phase.h"
+#include "scan.h"
+#include "solver.h"
+
+namespace d18 {
+
 struct Instruction {
   char dir;
   int num_steps;
-  std::string col;
+  std::string_view col;
 };
 
 std::int64_t area(const std::vector<Instruction>& instructions) {
@@ -60,26 +64,28 @@ std::int64_t area(const std::vector<Instruction>& instructions) {
   return total + boundary_bonus;
 }
 
-int main() {
-  std::ifstream fs("input.txt");
-  std::string line;
+aoc::Answer solve(std::string_view input) {
+  aoc::PhaseTimer timer("parse");
+
   std::vector<Instruction> instructions;
-  while (std::getline(fs, line)) {
+  for (std::string_view line : aoc::Lines(input)) {
     // Create instruction from line.
+    // Lines look like "R 6 (#70c710)".
     Instruction i;
-    std::stringstream ss(line);
-    std::string token;
-    ss >> token; i.dir = token[0];
-    ss >> token; i.num_steps = std::stoi(token);
-    ss >> token; i.col = token.substr(2, 6);
+    i.dir = line[0];
+    i.num_steps = aoc::NumberScanner(line.substr(1)).next<int>();
+    i.col = line.substr(line.find('#') + 1, 6);
     instructions.push_back(i);
   }
 
+  timer.next("P1");
   const std::int64_t p1 = area(instructions);
 
+  timer.next("P2");
+
   // Correct the instructions.
   for (auto& in : instructions) {
-    const int num = std::strtol(in.col.c_str(), NULL, 16);
+    const int num = aoc::to_number<int>(in.col, 16);
     in.num_steps = num >> 4;
 
     // Translate the direction into one of our recognisable chars.
@@ -93,7 +99,16 @@ int main() {
   }
 
   const std::int64_t p2 = area(instructions);
-  std::cout << "P1: " << p1 << ", P2: " << p2 << "\n";
 
-  return EXIT_SUCCESS;
+  timer.stop();
+
+  return {p1, p2};
+}
+
+}
+
+#ifndef AOC_LIBRARY
+int main(int argc, char** argv) {
+  return aoc::solver_main(argc, argv, d18::solve);
 }
+#endif
@@ -0,0 +1,61 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "generate.h"
+
+// Generates a dig plan like the real one (~700 instructions tracing out a simple rectilinear
+// loop, where the colour codes encode a second, much larger loop).
+//
+// Both loops are "combs": a row of teeth of random widths and heights sticking up from the
+// top of a rectangle. That keeps them simple (no self intersections) whatever the sizes,
+// and the number of instructions is the same for both which is all the format needs.
+// Scaling grows the number of instructions.
+
+struct Instruction {
+  char dir;
+  long steps;
+};
+
+std::vector<Instruction> comb(std::size_t num_teeth, long max_step, std::mt19937_64& rng) {
+  const auto step = [&rng, max_step] { return aoc::uniform(rng, 1L, max_step); };
+
+  std::vector<Instruction> instructions;
+  long width = step();
+  instructions.push_back({'R', width});
+  for (std::size_t i = 0; i < num_teeth; i++) {
+    const long height = step(), tooth = step(), gap = step();
+    instructions.push_back({'U', height});
+    instructions.push_back({'R', tooth});
+    instructions.push_back({'D', height});
+    instructions.push_back({'R', gap});
+    width += tooth + gap;
+  }
+
+  const long depth = step();
+  instructions.push_back({'D', depth});
+  instructions.push_back({'L', width});
+  instructions.push_back({'U', depth});
+  return instructions;
+}
+
+int main(int argc, char** argv) {
+  auto [scale, rng] = aoc::parse_generator_args(argc, argv);
+
+  const std::size_t num_teeth = std::max(1L, std::lround(179 * scale));
+
+  // The colours only have five hex digits for the distance so the bottom edge of the
+  // second comb has to fit in that.
+  const long max_colour_step = std::max(1L, ((1L << 20) - 1) / static_cast<long>(2 * num_teeth + 1));
+
+  const auto plan = comb(num_teeth, 12, rng);
+  const auto colours = comb(num_teeth, std::min(max_colour_step, 500000L), rng);
+
+  constexpr std::array<char, 4> colour_dirs = {'R', 'D', 'L', 'U'};
+  for (std::size_t i = 0; i < plan.size(); i++) {
+    const auto colour_dir = std::find(colour_dirs.begin(), colour_dirs.end(), colours[i].dir) - colour_dirs.begin();
+    std::printf("%c %ld (#%05lx%ld)\n", plan[i].dir, plan[i].steps, colours[i].steps, static_cast<long>(colour_dir));
+  }
+}
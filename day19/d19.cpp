@@ -1,20 +1,31 @@
 #include <algorithm>
 #include <array>
-#include <fstream>
-#include <iostream>
 #include <optional>
 #include <queue>
-#include <string>
-#include <sstream>
+#include <string_view>
 #include <vector>
 
+#include "input.h"
+#include "labels.h"
+#include "phase.h"
+#include "scan.h"
+#include "solver.h"
+
+namespace d19 {
+
+// Workflow labels are interned (see labels.h) so everything below works with ids. "A" and
+// "R" get the first two.
+constexpr std::string_view label_alphabet = "abcdefghijklmnopqrstuvwxyzAR";
+constexpr std::uint32_t accepted = 0;
+constexpr std::uint32_t rejected = 1;
+
 struct Part {
   std::array<int, 4> categories;
 };
 
 // An interval over all categories.
 struct Interval {
-  std::string target_label;
+  std::uint32_t target;
   std::array<std::pair<int, int>, 4> category_intervals;
 
   std::uint64_t num_elements() const {
@@ -30,7 +41,7 @@ struct Step {
   int category;
   char op;
   int val;
-  std::string output_label;
+  std::uint32_t output;
 
   bool is_fallthrough() const {
     return op == ' ';
@@ -48,7 +59,7 @@ struct Step {
   std::pair<std::optional<Interval>, std::optional<Interval>> match_interval(const Interval& i) const {
     if (is_fallthrough()) {
       Interval fallthrough_interval(i);
-      fallthrough_interval.target_label = output_label;
+      fallthrough_interval.target = output;
       return std::make_pair(fallthrough_interval, std::nullopt);
     }
 
@@ -61,12 +72,14 @@ struct Step {
 
       if (category_interval.second < val) {
         // Whole thing matches.
-        return std::make_pair(i, std::nullopt);
+        Interval matching_interval(i);
+        matching_interval.target = output;
+        return std::make_pair(matching_interval, std::nullopt);
       }
 
       // Need to split.
       Interval matching_interval(i);
-      matching_interval.target_label = output_label;
+      matching_interval.target = output;
       matching_interval.category_intervals[category].second = val - 1;
       Interval fallthrough_interval(i);
       fallthrough_interval.category_intervals[category].first = val;
@@ -80,12 +93,14 @@ struct Step {
 
       if (category_interval.first > val) {
         // Whole thing matches.
-        return std::make_pair(i, std::nullopt);
+        Interval matching_interval(i);
+        matching_interval.target = output;
+        return std::make_pair(matching_interval, std::nullopt);
       }
 
       // Need to split.
       Interval matching_interval(i);
-      matching_interval.target_label = output_label;
+      matching_interval.target = output;
       matching_interval.category_intervals[category].first = val + 1;
       Interval fallthrough_interval(i);
       fallthrough_interval.category_intervals[category].second = val;
@@ -95,13 +110,13 @@ struct Step {
 };
 
 struct Workflow {
-  std::string label;
+  std::uint32_t id;
   std::vector<Step> steps;
 
-  std::string execute(const Part& p) const {
+  std::uint32_t execute(const Part& p) const {
     for (const auto& step : steps) {
       if (step.matches_part(p)) {
-        return step.output_label;
+        return step.output;
       }
     }
 
@@ -109,31 +124,22 @@ struct Workflow {
   }
 };
 
-const Workflow& find_workflow(const std::string& label, const std::vector<Workflow>& workflows) {
-  for (const auto& w : workflows) {
-    if (w.label == label) return w;
+// Workflows are indexed by id.
+bool is_accepted(const Part& p, const std::vector<Workflow>& workflows, std::uint32_t start) {
+  std::uint32_t id = start;
+  while (id != accepted && id != rejected) {
+    id = workflows[id].execute(p);
   }
 
-  std::abort();
+  return id == accepted;
 }
 
-bool is_accepted(const Part& p, const std::vector<Workflow>& workflows) {
-  // Locate the "in" workflow.
-  std::string label = "in";
-  while (label != "A" && label != "R") {
-    const Workflow& w = find_workflow(label, workflows);
-    label = w.execute(p);
-  }
-
-  return label == "A";
-}
-
-std::uint64_t count_all_possible_parts(const std::vector<Workflow>& workflows) {
+std::uint64_t count_all_possible_parts(const std::vector<Workflow>& workflows, std::uint32_t start_id) {
   // Do interval calculation to find all possible parts which would be accepted.
   std::uint64_t total = 0;
 
   Interval start {
-    "in",
+    start_id,
     std::make_pair(1, 4000),
     std::make_pair(1, 4000),
     std::make_pair(1, 4000),
@@ -148,7 +154,7 @@ std::uint64_t count_all_possible_parts(const std::vector<Workflow>& workflows) {
 
     // Feed this interval through its target workflow and create new intervals.
     // We can resolve intervals when end up with the "A" or "R" target.
-    const auto& w = find_workflow(current.target_label, workflows);
+    const auto& w = workflows[current.target];
     for (const auto& s : w.steps) {
       // Feed the current interval through this step.
       // In the common case some portion on the interval will match and some will not causing it to fall through to
@@ -156,59 +162,57 @@ std::uint64_t count_all_possible_parts(const std::vector<Workflow>& workflows) {
       auto [matching, passthrough] = s.match_interval(current);
 
       if (matching) {
-        if (matching->target_label == "A") {
+        if (matching->target == accepted) {
           total += matching->num_elements();
         }
-        else if (matching->target_label != "R") {
+        else if (matching->target != rejected) {
           // Enqueue this interval.
           todo.push(*matching);
         }
       }
 
-      if (passthrough) {
-        // Try to match this interval on the next step.
-        current = *passthrough;
-      }
+      if (!passthrough) break;
+
+      // Try to match this interval on the next step.
+      current = *passthrough;
     }
   }
 
   return total;
 }
 
-int main() {
-  std::ifstream fs("input.txt");
-  std::string line, token;
+aoc::Answer solve(std::string_view input) {
+  aoc::PhaseTimer timer("parse");
+
+  aoc::LabelInterner ids(label_alphabet, 3);
+  ids.intern("A");
+  ids.intern("R");
+
   std::vector<Workflow> workflows;
   std::vector<Part> parts;
   bool in_parts = false;
-  while (std::getline(fs, line)) {
+  for (std::string_view line : aoc::Lines(input)) {
     if (line.empty()) {
       in_parts = true;
       continue;
     }
 
     // We're going to need to split by each of "{}:,".
-    std::replace(line.begin(), line.end(), '{', ' ');
-    std::replace(line.begin(), line.end(), '}', ' ');
-    std::replace(line.begin(), line.end(), ':', ' ');
-    std::replace(line.begin(), line.end(), ',', ' ');
-
-    std::stringstream ss(line);
+    static constexpr std::string_view delims = "{}:,";
 
     if (in_parts) {
+      aoc::NumberScanner scanner(line);
       Part p;
-      ss >> token; p.categories[0] = std::stoi(token.substr(2));
-      ss >> token; p.categories[1] = std::stoi(token.substr(2));
-      ss >> token; p.categories[2] = std::stoi(token.substr(2));
-      ss >> token; p.categories[3] = std::stoi(token.substr(2));
+      for (auto& category : p.categories) {
+        category = scanner.next<int>();
+      }
       parts.push_back(p);
     }
     else {
       Workflow w;
-      ss >> token; w.label = token;
-      while (ss) {
+      w.id = ids.intern(aoc::next_token(line, delims));
+      for (auto token = aoc::next_token(line, delims); !token.empty(); token = aoc::next_token(line, delims)) {
         Step s;
-        ss >> token;
 
         // Is this a comparison or a label?
         const bool is_comparison = token.size() > 1 && (token[1] == '<' || token[1] == '>');
@@ -221,16 +225,15 @@ int main() {
             case 's': s.category = 3; break;
           }
           s.op = token[1];
-          s.val = std::stoi(token.substr(2));
-          ss >> s.output_label;
+          s.val = aoc::to_number<int>(token.substr(2));
+          s.output = ids.intern(aoc::next_token(line, delims));
         }
         else {
           // This is the fallthrough label.
           s.category = ' ';
           s.val = 0;
           s.op = ' ';
-          s.output_label = token;
-          ss >> token;
+          s.output = ids.intern(token);
         }
 
         w.steps.push_back(s);
@@ -240,16 +243,38 @@ int main() {
     }
   }
 
+  // Put each workflow where its id says it goes ("A" and "R" just get an empty one).
+  std::vector<Workflow> workflows_by_id(ids.size());
+  for (auto& w : workflows) {
+    const std::uint32_t id = w.id;
+    workflows_by_id[id] = std::move(w);
+  }
+  workflows = std::move(workflows_by_id);
+
+  const std::uint32_t start = ids.find("in");
+
+  timer.next("P1");
+
   int total1 = 0;
   for (const auto& p : parts) {
-    if (is_accepted(p, workflows)) {
+    if (is_accepted(p, workflows, start)) {
       total1 += p.categories[0] + p.categories[1] + p.categories[2] + p.categories[3];
     }
   }
 
-  const std::uint64_t total2 = count_all_possible_parts(workflows);
+  timer.next("P2");
 
-  std::cout << "P1: " << total1 << ", P2: " << total2 << "\n";
+  const std::uint64_t total2 = count_all_possible_parts(workflows, start);
+
+  timer.stop();
+
+  return {total1, static_cast<std::int64_t>(total2)};
+}
+
+}
 
-  return EXIT_SUCCESS;
+#ifndef AOC_LIBRARY
+int main(int argc, char** argv) {
+  return aoc::solver_main(argc, argv, d19::solve);
 }
+#endif
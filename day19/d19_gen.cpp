@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "generate.h"
+
+// Generates workflows and parts like the real input (~580 workflows with two to four rules
+// each, then ~200 parts). The workflows form a tree rooted at "in" so that every part ends
+// up accepted or rejected, with leaves sending parts to "A" or "R".
+// Scaling grows the number of workflows and parts.
+
+constexpr std::array<char, 4> categories = {'x', 'm', 'a', 's'};
+
+int main(int argc, char** argv) {
+  auto [scale, rng] = aoc::parse_generator_args(argc, argv);
+
+  const std::size_t num_workflows = std::max(1L, std::lround(580 * scale));
+  const std::size_t num_parts = std::max(1L, std::lround(200 * scale));
+
+  aoc::LabelPool labels("abcdefghijklmnopqrstuvwxyz", 2);
+  labels.reserve("in");
+
+  // Grow the tree breadth first until we've handed out enough workflow labels, then point
+  // everything else at the terminal states.
+  std::size_t num_created = 1;
+  std::queue<std::string> todo;
+  todo.push("in");
+  while (!todo.empty()) {
+    const auto label = todo.front();
+    todo.pop();
+
+    const auto target = [&] {
+      if (num_created < num_workflows && aoc::uniform(rng, 0, 3) != 0) {
+        ++num_created;
+        todo.push(labels.next(rng));
+        return todo.back();
+      }
+      return std::string(aoc::uniform(rng, 0, 1) ? "A" : "R");
+    };
+
+    std::printf("%s{", label.c_str());
+    const int num_rules = aoc::uniform(rng, 1, 3);
+    for (int i = 0; i < num_rules; i++) {
+      const char category = categories[aoc::uniform(rng, 0, 3)];
+      const char op = aoc::uniform(rng, 0, 1) ? '<' : '>';
+      std::printf("%c%c%d:%s,", category, op, aoc::uniform(rng, 1, 4000), target().c_str());
+    }
+    std::printf("%s}\n", target().c_str());
+  }
+
+  std::printf("\n");
+  for (std::size_t i = 0; i < num_parts; i++) {
+    std::printf("{x=%d,m=%d,a=%d,s=%d}\n",
+      aoc::uniform(rng, 1, 4000), aoc::uniform(rng, 1, 4000), aoc::uniform(rng, 1, 4000), aoc::uniform(rng, 1, 4000));
+  }
+}
@@ -1,14 +1,21 @@
 #include <algorithm>
 #include <array>
-#include <fstream>
+#include <cstdint>
 #include <functional>
-#include <iostream>
 #include <optional>
 #include <queue>
 #include <string>
-#include <sstream>
+#include <string_view>
 #include <vector>
 
+#include "input.h"
+#include "labels.h"
+#include "phase.h"
+#include "solver.h"
+#include "work_stealing.h"
+
+namespace d20 {
+
 enum NodeType {
   UNKNOWN,
   BT,
@@ -19,7 +26,6 @@ enum NodeType {
 
 struct Node {
   bool populated;
-  std::string label;
   NodeType type;
   std::vector<Node*> inputs;
   std::vector<Node*> targets;
@@ -64,10 +70,6 @@ struct Pulse {
   bool is_high;
 };
 
-int index_from_label(const std::string& label) {
-  return 26 * (label[0] - 'a') + (label[1] - 'a');
-}
-
 std::pair<int, int> push_button(const Node& button) {
   int num_low_pulses = 0;
   int num_high_pulses = 0;
@@ -131,42 +133,74 @@ std::pair<int, int> push_button(const Node& button) {
   return std::make_pair(num_low_pulses, num_high_pulses);
 }
 
-void reset(std::array<Node, 26*26>& nodes) {
-  for (Node& n : nodes) {
-    if (!n.populated) continue;
-    n.ff_is_on = false;
-    for (std::size_t i = 0; i < n.latest_state_sent_to_target.size(); i++) {
-      n.latest_state_sent_to_target[i] = false;
+// The whole module configuration. Nodes point at each other, so copying a network
+// redirects all of the copy's pointers to its own nodes. That gives every search its own
+// state to push the button on.
+struct Network {
+  Node button{};
+  Node broadcaster{};
+
+  // Indexed by the id of the module's label.
+  std::vector<Node> nodes;
+
+  Network() = default;
+
+  Network(const Network& other)
+    : button(other.button), broadcaster(other.broadcaster), nodes(other.nodes) {
+    const auto translate = [this, &other] (Node*& n) {
+      if (n == &other.button) n = &button;
+      else if (n == &other.broadcaster) n = &broadcaster;
+      else n = &nodes[n - other.nodes.data()];
+    };
+
+    for (Node* n : {&button, &broadcaster}) {
+      for (Node*& input : n->inputs) translate(input);
+      for (Node*& target : n->targets) translate(target);
+    }
+    for (Node& n : nodes) {
+      for (Node*& input : n.inputs) translate(input);
+      for (Node*& target : n.targets) translate(target);
     }
   }
-}
 
-int main() {
-  std::ifstream fs("input.txt");
-  std::string line, token;
+  Network& operator=(const Network&) = delete;
+};
+
+aoc::Answer solve(std::string_view input) {
+  aoc::PhaseTimer timer("parse");
 
-  Node button, broadcaster;
-  std::array<Node, 26*26> nodes;
-  for (auto& n : nodes) n.populated = false;
+  Network network;
+  Node& button = network.button;
+  Node& broadcaster = network.broadcaster;
+  auto& nodes = network.nodes;
 
   button.type = BT;
   button.targets.push_back(&broadcaster);
   button.latest_state_sent_to_target.push_back(false);
 
-  while (std::getline(fs, line)) {
-    std::stringstream ss(line);
-    ss >> token;
+  // Give every module a dense id up front, so that the nodes can all be created before
+  // anything starts pointing at them.
+  aoc::LabelInterner ids(aoc::lowercase, 3);
+  for (std::string_view line : aoc::Lines(input)) {
+    for (auto token = aoc::next_token(line, " ,"); !token.empty(); token = aoc::next_token(line, " ,")) {
+      if (token == "->" || token == "broadcaster") continue;
+      if (token[0] == '%' || token[0] == '&') token.remove_prefix(1);
+      ids.intern(token);
+    }
+  }
+  nodes.resize(ids.size());
+
+  for (std::string_view line : aoc::Lines(input)) {
+    auto token = aoc::next_token(line);
 
     // Which node are we populating?
     Node* n = nullptr;
     if (token[0] == 'b') {
       n = &broadcaster;
-      n->label = "broadcaster";
       n->type = BR;
     }
     else {
-      n = &nodes[index_from_label(token.substr(1))];
-      n->label = token.substr(1);
+      n = &nodes[ids.find(token.substr(1))];
       n->type = token[0] == '%' ? FF : CN;
       n->ff_is_on = false;
     }
@@ -174,27 +208,35 @@ int main() {
     n->populated = true;
 
     // Ignore the arrow.
-    ss >> token;
+    aoc::next_token(line);
 
     // Populate the targets.
-    ss >> token;
-    while (ss) {
-      Node* target = &nodes[index_from_label(token.substr(0, 2))];
+    for (token = aoc::next_token(line, " ,"); !token.empty(); token = aoc::next_token(line, " ,")) {
+      Node* target = &nodes[ids.find(token)];
       n->targets.push_back(target);
       n->latest_state_sent_to_target.push_back(false);
       target->inputs.push_back(n);
-      ss >> token;
     }
   }
 
-  int low_total = 0, high_total = 0;
-  for (int i = 0; i < 1000; i++) {
-    auto [low, high] = push_button(button);
-    low_total += low;
-    high_total += high;
-  }
+  timer.stop();
+
+  // P1 and each of the P2 period searches work on their own copy of the network, so they
+  // can all run side by side.
+  std::int64_t p1;
+  const auto part1 = [&network, &p1] {
+    aoc::PhaseTimer phase("P1", aoc::PhaseScope::Thread);
+
+    Network net(network);
+    std::int64_t low_total = 0, high_total = 0;
+    for (int i = 0; i < 1000; i++) {
+      auto [low, high] = push_button(net.button);
+      low_total += low;
+      high_total += high;
+    }
 
-  const int p1 = low_total * high_total;
+    p1 = low_total * high_total;
+  };
 
   // For part 2 I've made some deductions based on the actual shape of my particular
   // network (presumably other inputs have similar patterns).
@@ -217,38 +259,61 @@ int main() {
   // nodes zq, kx, zd and mt must all be high.
   // I assume that there is some periodic behaviour at work. Let's work out the periods!
 
+  // Other networks (the examples, say) won't have these modules, and then there's no part 2.
+  static constexpr std::array<const char*, 4> labels = {"zq", "kx", "zd", "mt"};
+  std::array<std::uint32_t, 4> watched;
+  for (std::size_t i = 0; i < labels.size(); i++) watched[i] = ids.find(labels[i]);
+  if (std::count(watched.begin(), watched.end(), aoc::LabelInterner::none)) {
+    part1();
+    return {p1, std::nullopt};
+  }
+
   std::uint64_t prod = 1;
-  bool all_inputs_on;
-  const auto all_inputs_on_detected = [&all_inputs_on] () { all_inputs_on = true; };
-  for (const auto& label : {"zq", "kx", "zd", "mt"}) {
-    reset(nodes);
-
-    Node* n = &nodes[index_from_label(label)];
-    n->all_inputs_on_callback = all_inputs_on_detected;
-
-    // Push the button until the inputs first come on.
-    all_inputs_on = false;
-    while (!all_inputs_on) {
-      push_button(button);
-    }
+  const auto part2 = [&network, &watched, &prod] {
+    // This forks the period searches, so its figures are process wide and include P1.
+    aoc::PhaseTimer phase("P2");
 
-    // We're in a "clean" state now so go around again and see what the period is.
-    int num_presses = 0;
-    all_inputs_on = false;
-    while (!all_inputs_on) {
-      push_button(button);
-      ++num_presses;
-    }
+    std::array<int, 4> periods;
+    aoc::parallel_for(labels.size(), [&network, &watched, &periods] (std::size_t i) {
+      const std::string phase_name = std::string("P2/") + labels[i];
+      aoc::PhaseTimer detail(phase_name.c_str(), aoc::PhaseScope::Thread);
+
+      Network net(network);
+
+      bool all_inputs_on;
+      Node* n = &net.nodes[watched[i]];
+      n->all_inputs_on_callback = [&all_inputs_on] () { all_inputs_on = true; };
+
+      // Push the button until the inputs first come on.
+      all_inputs_on = false;
+      while (!all_inputs_on) {
+        push_button(net.button);
+      }
 
-    n->all_inputs_on_callback = std::nullopt;
+      // We're in a "clean" state now so go around again and see what the period is.
+      int num_presses = 0;
+      all_inputs_on = false;
+      while (!all_inputs_on) {
+        push_button(net.button);
+        ++num_presses;
+      }
 
-    std::cout << "All high for label: " << label << " at: " << num_presses << std::endl;
+      periods[i] = num_presses;
+    });
 
     // Note: in my case all periods were prime. If this was not true then need to LCM.
-    prod *= num_presses;
-  }
+    for (int period : periods) prod *= period;
+  };
+
+  aoc::parallel_invoke(part1, part2);
 
-  std::cout << "P1: " << p1 << ", P2: " << prod << "\n";
+  return {p1, static_cast<std::int64_t>(prod)};
+}
+
+}
 
-  return EXIT_SUCCESS;
+#ifndef AOC_LIBRARY
+int main(int argc, char** argv) {
+  return aoc::solver_main(argc, argv, d20::solve);
 }
+#endif
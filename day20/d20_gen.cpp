@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "generate.h"
+
+// Generates a pulse network like the real one: the broadcaster feeds four 12 bit binary
+// counters built from flip-flops. Each counter's conjunction fires (and resets the counter)
+// once the count reaches a prime period, and the counters are combined through inverters
+// into a final conjunction which feeds "rx".
+//
+// The first four counters use the labels that the part 2 solution expects.
+// Scaling grows the number of counters.
+
+constexpr int counter_bits = 12;
+
+bool is_prime(int n) {
+  for (int d = 2; d * d <= n; d++) {
+    if (n % d == 0) return false;
+  }
+  return n > 1;
+}
+
+struct Module {
+  char type;
+  std::string label;
+  std::vector<std::string> targets;
+};
+
+int main(int argc, char** argv) {
+  auto [scale, rng] = aoc::parse_generator_args(argc, argv);
+
+  const std::size_t num_counters = std::max(1L, std::lround(4 * scale));
+
+  // d20 takes labels of up to three letters.
+  aoc::LabelPool labels("abcdefghijklmnopqrstuvwxyz", 2, 3);
+  const std::vector<std::string> counter_labels = {"zq", "kx", "zd", "mt"};
+  const std::vector<std::string> inverter_labels = {"qz", "cq", "jx", "tt"};
+  for (const auto& l : counter_labels) labels.reserve(l);
+  for (const auto& l : inverter_labels) labels.reserve(l);
+  labels.reserve("qn");
+  labels.reserve("rx");
+
+  // Periods need the top bit set so that every flip-flop in the counter is used.
+  std::vector<int> primes;
+  for (int p = (1 << (counter_bits - 1)) + 1; p < (1 << counter_bits); p++) {
+    if (is_prime(p)) primes.push_back(p);
+  }
+  std::shuffle(primes.begin(), primes.end(), rng);
+
+  std::vector<Module> modules;
+  Module broadcaster{' ', "broadcaster", {}};
+  Module final_conjunction{'&', "qn", {"rx"}};
+
+  for (std::size_t c = 0; c < num_counters; c++) {
+    const int period = primes[c % primes.size()];
+
+    Module counter{'&', c < counter_labels.size() ? counter_labels[c] : labels.next(rng), {}};
+    Module inverter{'&', c < inverter_labels.size() ? inverter_labels[c] : labels.next(rng), {"qn"}};
+    counter.targets.push_back(inverter.label);
+
+    std::vector<Module> flip_flops;
+    for (int bit = 0; bit < counter_bits; bit++) {
+      flip_flops.push_back(Module{'%', labels.next(rng), {}});
+    }
+
+    broadcaster.targets.push_back(flip_flops[0].label);
+
+    // Set bits of the period feed the conjunction, which resets the clear bits (and the
+    // lowest bit, which is always set) by pulsing them.
+    for (int bit = 0; bit < counter_bits; bit++) {
+      auto& ff = flip_flops[bit];
+      if (bit + 1 < counter_bits) ff.targets.push_back(flip_flops[bit + 1].label);
+      if (period & (1 << bit)) ff.targets.push_back(counter.label);
+      if (!(period & (1 << bit)) || bit == 0) counter.targets.push_back(ff.label);
+      std::shuffle(ff.targets.begin(), ff.targets.end(), rng);
+    }
+
+    std::shuffle(counter.targets.begin(), counter.targets.end(), rng);
+
+    modules.insert(modules.end(), flip_flops.begin(), flip_flops.end());
+    modules.push_back(counter);
+    modules.push_back(inverter);
+  }
+
+  modules.push_back(broadcaster);
+  modules.push_back(final_conjunction);
+  std::shuffle(modules.begin(), modules.end(), rng);
+
+  for (const auto& m : modules) {
+    if (m.type != ' ') std::putchar(m.type);
+    std::printf("%s ->", m.label.c_str());
+    for (std::size_t i = 0; i < m.targets.size(); i++) {
+      std::printf("%s %s", i ? "," : "", m.targets[i].c_str());
+    }
+    std::printf("\n");
+  }
+}
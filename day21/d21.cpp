@@ -1,13 +1,18 @@
 #include <array>
-#include <fstream>
-#include <iomanip>
-#include <iostream>
 #include <queue>
 #include <set>
-#include <string>
+#include <string_view>
 #include <tuple>
 #include <vector>
 
+#include "counters.h"
+#include "grid.h"
+#include "input.h"
+#include "phase.h"
+#include "solver.h"
+
+namespace d21 {
+
 enum Direction : std::uint8_t { N, E, S, W };
 
 const std::array<Direction, 4> inverse_direction{S, W, N, E};
@@ -21,27 +26,27 @@ constexpr std::array<std::pair<int, int>, 4> offsets = {
 
 class Map {
 public:
-  Map(const std::vector<std::string>&);
+  Map(const std::vector<std::string_view>&);
   std::uint32_t count_locations_after_exact_steps(std::uint32_t) const;
 
 private:
   std::uint32_t start_x_, start_y_;
-  std::size_t width_, height_;
-  std::vector<std::string> grid_;
-};
 
-Map::Map(const std::vector<std::string>& grid)
-  : width_(grid[0].size()), height_(grid.size()), grid_(grid) {
+  // The map repeats forever, so wrap it round. Two cells of border cover both steps taken
+  // from each location in the search.
+  aoc::Grid grid_;
+};
 
-  // Find the start location and mark as garden plot.
-  for (std::size_t y = 0; y < height_; y++) {
-    for (std::size_t x = 0; x < height_; x++) {
-      if (grid_[y][x] == 'S') {
-        grid_[y][x] = '.';
+Map::Map(const std::vector<std::string_view>& grid)
+  : grid_(aoc::Grid::toroidal(grid, 2)) {
 
+  // Find the start location (it's a garden plot, only '#' is ever checked for).
+  for (int y = 0; y < grid_.height(); y++) {
+    for (int x = 0; x < grid_.width(); x++) {
+      if (grid_.at(x, y) == 'S') {
         // Boost the start location to make hashing easier.
-        start_x_ = x + 1000 * width_;
-        start_y_ = y + 1000 * height_;
+        start_x_ = x + 1000 * grid_.width();
+        start_y_ = y + 1000 * grid_.height();
         return;
       }
     }
@@ -77,7 +82,7 @@ std::uint32_t Map::count_locations_after_exact_steps(std::uint32_t num_steps) co
       const std::uint32_t next_y = start_y_ + offset.second;
 
       // Is this location blocked?
-      if (grid_[next_y % height_][next_x % width_] == '#') continue;
+      if (grid_[grid_.wrapped_index(next_x, next_y)] == '#') continue;
 
       // Have we already reached this location with a lower step count of the
       // same parity?
@@ -92,10 +97,15 @@ std::uint32_t Map::count_locations_after_exact_steps(std::uint32_t num_steps) co
     reached_locations.insert(start);
   }
 
+  aoc::PerfCounters counters("count_locations_after_exact_steps");
   while (!todo.empty()) {
     auto current = todo.front();
     todo.pop();
 
+    // Only the current location needs wrapping onto the map, the border takes care of the
+    // steps from there.
+    const aoc::Grid::Index current_index = grid_.wrapped_index(current.x, current.y);
+
     // Take two steps.
     for (const auto d : {N, E, S, W}) {
       const auto& offset = offsets[d];
@@ -104,7 +114,8 @@ std::uint32_t Map::count_locations_after_exact_steps(std::uint32_t num_steps) co
       const std::uint32_t next_y = current.y + offset.second;
 
       // Is this location blocked?
-      if (grid_[next_y % height_][next_x % width_] == '#') continue;
+      const aoc::Grid::Index next_index = current_index + grid_.offsets()[d];
+      if (grid_[next_index] == '#') continue;
 
       // Consider neighbours of this neighbour.
       for (const auto d2 : {N, E, S, W}) {
@@ -116,7 +127,7 @@ std::uint32_t Map::count_locations_after_exact_steps(std::uint32_t num_steps) co
         const std::uint32_t next_y2 = next_y + offset2.second;
 
         // Is this location blocked?
-        if (grid_[next_y2 % height_][next_x2 % width_] == '#') continue;
+        if (grid_[next_index + grid_.offsets()[d2]] == '#') continue;
 
         Node next2{next_x2, next_y2, current.steps_taken + 2};
         if (reached_locations.find(next2) != reached_locations.end()) continue;
@@ -129,82 +140,64 @@ std::uint32_t Map::count_locations_after_exact_steps(std::uint32_t num_steps) co
       }
     }
   }
+  counters.stop();
 
   return reached_locations.size();
 }
 
-std::array<long double, 3> second_order_regression(
-  const std::vector<int>& xs,
-  const std::vector<int>& ys) {
-
-  std::uint64_t sx = 0, sy = 0, sx2 = 0, sx3 = 0, sxy = 0, sx2y = 0, sx4 = 0;
-  for (std::size_t i = 0; i < xs.size(); i++) {
-    std::uint64_t x = xs[i], y = ys[i];
-    sx += x;
-    sy += y;
-    sx2 += x * x;
-    sx3 += x * x * x;
-    sxy += x * y;
-    sx2y += x * x * y;
-    sx4 += x * x * x * x;
-  }
-
-  const auto n = static_cast<long double>(xs.size());
-  const double Sxx = sx2 - (sx * sx) / n;
-  const double Sxy = sxy - (sx * sy) / n;
-  const double Sxx2 = sx3 - (sx * sx2) / n;
-  const double Sx2y = sx2y - (sx2 * sy) / n;
-  const double Sx2x2 = sx4 - (sx2 * sx2) / n;
-
-  const long double a = (Sx2y * Sxx - Sxy * Sxx2) / (Sxx * Sx2x2 - Sxx2 * Sxx2);
-  const long double b = (Sxy * Sx2x2 - Sx2y * Sxx2) / (Sxx * Sx2x2 - Sxx2 * Sxx2);
-  const long double c = (sy / n) - (b * (sx / n)) - (a * (sx2 / n));
-
-  return { a, b, c };
+// Evaluate the quadratic passing through (0, ys[0]), (1, ys[1]), (2, ys[2]) at n using
+// Newton forward differences. Everything stays in integers so the result is exact.
+std::int64_t extrapolate_quadratic(const std::array<std::int64_t, 3>& ys, std::int64_t n) {
+  const std::int64_t d1 = ys[1] - ys[0];
+  const std::int64_t d2 = ys[2] - 2 * ys[1] + ys[0];
+  return ys[0] + n * d1 + n * (n - 1) / 2 * d2;
 }
 
-long double eval(const std::array<long double, 3>& coeffs, std::uint64_t x) {
-  return coeffs[0] * x * x + coeffs[1] * x + coeffs[2];
-}
+aoc::Answer solve(std::string_view input) {
+  aoc::PhaseTimer timer("parse");
 
-int main() {
-  std::ifstream fs("input.txt");
-  std::vector<std::string> grid;
-  std::string line;
-  while (std::getline(fs, line)) {
+  std::vector<std::string_view> grid;
+  for (std::string_view line : aoc::Lines(input)) {
     grid.push_back(line);
   }
 
   Map m(grid);
 
+  timer.next("P1");
   const auto p1 = m.count_locations_after_exact_steps(64);
-  std::cout << "P1: " << p1 << std::endl;
+
+  timer.next("P2");
 
   // Examining the example data we're given, we can make a guess that we're looking at a
   // quadratic equation in the number of steps.
   // It turns out that this is correct, and the approach I've taken is to use my brute
   // force approach to generate as much data as possible and then fit a second order curve
   // to it which we can use to estimate the result.
+  //
+  // Note: the curve fit has since been replaced. Three samples at the same offset into the
+  // first three grid repeats pin the quadratic down exactly, and extrapolating from those
+  // in integers gives the exact answer, where the regression estimates only came close.
   constexpr int target_steps = 26501365;
   const std::size_t s = grid.size();
   const int r = target_steps % s;
 
-  std::vector<int> xs, ys;
-  int grid_step = 0;
-  while (true) {
-    int steps = grid.size() * grid_step + r;
-    ++grid_step;
+  std::array<std::int64_t, 3> counts;
+  for (int grid_step = 0; grid_step < 3; grid_step++) {
+    const int steps = s * grid_step + r;
+    counts[grid_step] = m.count_locations_after_exact_steps(steps);
+  }
 
-    const auto count = m.count_locations_after_exact_steps(steps);
-    std::cout << "Steps: " << steps << " can reach: " << count << "\n";
+  const std::int64_t p2 = extrapolate_quadratic(counts, target_steps / s);
 
-    xs.push_back(steps);
-    ys.push_back(count);
+  timer.stop();
 
-    if (xs.size() >= 3) {
-      const auto f = second_order_regression(xs, ys);
-      const auto estimate = eval(f, target_steps);
-      std::cout << "Best estimate: " << std::setprecision(15) << estimate << "\n";
-    }
-  }
+  return {p1, p2};
+}
+
+}
+
+#ifndef AOC_LIBRARY
+int main(int argc, char** argv) {
+  return aoc::solver_main(argc, argv, d21::solve);
 }
+#endif
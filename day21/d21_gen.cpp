@@ -0,0 +1,38 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "generate.h"
+
+// Generates a garden map like the real one: a square with an odd side, the start in the
+// middle, ~15% rocks, and a clear middle row, middle column and diamond between the edge
+// midpoints (the part 2 extrapolation relies on those being clear).
+// Scaling grows the number of cells, so the side grows with the square root of the scale.
+// Note that the part 2 answer is only meaningful when 26501365 steps end exactly on a tile
+// edge, which needs the side to divide 2 * 26501365 + 1 (i.e. 131 or 393).
+
+int main(int argc, char** argv) {
+  auto [scale, rng] = aoc::parse_generator_args(argc, argv);
+
+  const long side = std::max(5L, std::lround(131 * std::sqrt(scale))) | 1;
+  const long mid = side / 2;
+
+  std::vector<std::string> grid(side, std::string(side, '.'));
+  for (long y = 0; y < side; y++) {
+    for (long x = 0; x < side; x++) {
+      if (x == mid || y == mid) continue;
+      if (std::abs(x - mid) + std::abs(y - mid) == mid) continue;
+      if (aoc::uniform(rng, 0, 99) < 15) grid[y][x] = '#';
+    }
+  }
+
+  grid[mid][mid] = 'S';
+
+  for (const auto& row : grid) {
+    std::fwrite(row.data(), 1, row.size(), stdout);
+    std::putchar('\n');
+  }
+}
@@ -1,15 +1,15 @@
 #include <algorithm>
-#include <array>
 #include <cassert>
-#include <fstream>
-#include <iostream>
 #include <set>
-#include <sstream>
-#include <string>
+#include <string_view>
 #include <vector>
 
-static constexpr std::size_t base_size = 10;
-static constexpr std::size_t max_height = 1000;
+#include "input.h"
+#include "phase.h"
+#include "scan.h"
+#include "solver.h"
+
+namespace d22 {
 
 struct Point {
   int x, y, z;
@@ -65,9 +65,13 @@ private:
   int removed_id_;
   std::vector<Block> blocks_;
 
-  // 2D grid of stacks.
-  // Each locations is either zero (unoccupied) or has a block id.
-  std::array<std::array<std::array<int, max_height>, base_size>, base_size> occupied_stacks_;
+  // 2D grid of stacks, sized to fit the blocks (they only ever move down).
+  // Each locations is either -1 (unoccupied) or has a block id.
+  std::size_t width_, depth_, height_;
+  std::vector<int> occupied_stacks_;
+
+  int& stack_at(const Point& p) { return occupied_stacks_[(p.x * depth_ + p.y) * height_ + p.z]; }
+  int stack_at(const Point& p) const { return occupied_stacks_[(p.x * depth_ + p.y) * height_ + p.z]; }
 };
 
 Tetris::Tetris(const std::vector<Block>& blocks)
@@ -85,24 +89,27 @@ Tetris::Tetris(const std::vector<Block>& blocks)
     blocks_[id].id = id;
   }
 
-  // Fill the occupied stacks with zeros initially.
-  for (std::size_t x = 0; x < base_size; x++) {
-    for (std::size_t y = 0; y < base_size; y++) {
-      occupied_stacks_[x][y].fill(-1);
+  // Leave room above the highest block for checking what's resting on top.
+  width_ = depth_ = height_ = 0;
+  for (const auto& b : blocks_) {
+    for (const auto& p : b.points) {
+      width_ = std::max<std::size_t>(width_, p.x + 1);
+      depth_ = std::max<std::size_t>(depth_, p.y + 1);
+      height_ = std::max<std::size_t>(height_, p.z + 2);
     }
   }
+
+  // Fill the occupied stacks with -1 initially.
+  occupied_stacks_.assign(width_ * depth_ * height_, -1);
 }
 
 Tetris::Tetris(const Tetris& other)
   : removed_id_(-1),
-    blocks_(other.blocks_) {
-
-  // Empty occupied stacks state.
-  for (std::size_t x = 0; x < base_size; x++) {
-    for (std::size_t y = 0; y < base_size; y++) {
-      occupied_stacks_[x][y].fill(-1);
-    }
-  }
+    blocks_(other.blocks_),
+    width_(other.width_),
+    depth_(other.depth_),
+    height_(other.height_),
+    occupied_stacks_(width_ * depth_ * height_, -1) {
 }
 
 // Returns the number of blocks that move.
@@ -113,7 +120,7 @@ int Tetris::gravity() {
   const auto block_intersects = [this] (const Block& b) {
     for (const auto& p : b.points) {
       if (p.z < 1) return true; // Cannot go through the floor.
-      if (occupied_stacks_[p.x][p.y][p.z] != -1) return true;
+      if (stack_at(p) != -1) return true;
     }
     return false;
   };
@@ -133,7 +140,7 @@ int Tetris::gravity() {
 
     // Flag these locations as occupied.
     for (const auto& p : b.points) {
-      occupied_stacks_[p.x][p.y][p.z] = b.id;
+      stack_at(p) = b.id;
     }
 
     num_falling_blocks += will_move;
@@ -145,7 +152,7 @@ int Tetris::gravity() {
 void Tetris::remove_block(int id) {
   Block b = blocks_[id];
   for (const auto& p : b.points) {
-     occupied_stacks_[p.x][p.y][p.z] = -1;
+     stack_at(p) = -1;
   }
   removed_id_ = id;
 }
@@ -164,7 +171,7 @@ int Tetris::count_safe_disintegrations() const {
 
     std::set<int> ids_above;
     for (const auto& p : b.points) {
-      int id = occupied_stacks_[p.x][p.y][p.z];
+      int id = stack_at(p);
       if (id == -1 || id == b.id) continue;
       ids_above.insert(id);
     }
@@ -176,7 +183,7 @@ int Tetris::count_safe_disintegrations() const {
       Block b_above(blocks_[id]);
       b_above.lower();
       for (const auto& p : b_above.points) {
-        int id_below = occupied_stacks_[p.x][p.y][p.z];
+        int id_below = stack_at(p);
         if (id_below == -1 || id_below == b_above.id) continue;
 
         if (id_below != b.id) {
@@ -211,33 +218,44 @@ int Tetris::count_total_chain_reactions() const {
   return count;
 }
 
-int main() {
-  std::ifstream fs("input.txt");
+aoc::Answer solve(std::string_view input) {
+  aoc::PhaseTimer timer("parse");
+
+  // Each line is "x,y,z~x,y,z": six numbers per block.
   std::vector<Block> blocks;
-  std::string line, token;
-  while (std::getline(fs, line)) {
-    std::replace(line.begin(), line.end(), ',', ' ');
-    std::replace(line.begin(), line.end(), '~', ' ');
-
-    std::stringstream ss(line);
-
-    Point end1, end2;
-    ss >> token; end1.x = std::stoi(token);
-    ss >> token; end1.y = std::stoi(token);
-    ss >> token; end1.z = std::stoi(token);
-    ss >> token; end2.x = std::stoi(token);
-    ss >> token; end2.y = std::stoi(token);
-    ss >> token; end2.z = std::stoi(token);
-
-    Block b(end1, end2);
-    blocks.push_back(b);
+  aoc::NumberScanner scanner(input);
+  for (Point end1, end2; scanner.next(end1.x);) {
+    end1.y = scanner.next<int>();
+    end1.z = scanner.next<int>();
+    end2.x = scanner.next<int>();
+    end2.y = scanner.next<int>();
+    end2.z = scanner.next<int>();
+
+    blocks.push_back(Block(end1, end2));
   }
 
+  timer.next("P1");
+
+  aoc::PhaseTimer detail("P1/gravity");
   Tetris t(blocks);
   t.gravity();
 
+  detail.next("P1/safe_disintegrations");
   const int p1 = t.count_safe_disintegrations();
+  detail.stop();
+
+  timer.next("P2");
   const int p2 = t.count_total_chain_reactions();
 
-  std::cout << "P1: " << p1 << ", P2: " << p2 << "\n";
+  timer.stop();
+
+  return {p1, p2};
+}
+
+}
+
+#ifndef AOC_LIBRARY
+int main(int argc, char** argv) {
+  return aoc::solver_main(argc, argv, d22::solve);
 }
+#endif
@@ -0,0 +1,50 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "generate.h"
+
+// Generates a snapshot of falling bricks like the real one (~1500 bricks in a 10 x 10 column
+// up to z = 330, mostly horizontal and two to four cubes long).
+// Scaling grows the number of bricks. The footprint grows with the square root of the
+// scale so that the stack stays about as tall (and as densely packed) as the real one.
+
+constexpr int max_z = 330;
+
+int main(int argc, char** argv) {
+  auto [scale, rng] = aoc::parse_generator_args(argc, argv);
+
+  const std::size_t num_bricks = std::max(1L, std::lround(1485 * scale));
+  const int side = std::max(5L, std::lround(10 * std::sqrt(scale)));
+
+  std::vector<bool> occupied(static_cast<std::size_t>(side) * side * (max_z + 1), false);
+  const auto cell = [side] (int x, int y, int z) {
+    return (static_cast<std::size_t>(z) * side + y) * side + x;
+  };
+
+  for (std::size_t placed = 0; placed < num_bricks;) {
+    // Pick an orientation (1 in 6 vertical) and an extent of one to four extra cubes.
+    const int axis = std::min(aoc::uniform(rng, 0, 5), 2);
+    const int extra = std::min(aoc::uniform(rng, 0, 7), 4) * (aoc::uniform(rng, 0, 15) != 0);
+    int end[3] = {0, 0, 0};
+    end[axis] = extra;
+
+    const int x = aoc::uniform(rng, 0, side - 1 - end[0]);
+    const int y = aoc::uniform(rng, 0, side - 1 - end[1]);
+    const int z = aoc::uniform(rng, 1, max_z - end[2]);
+
+    bool clear = true;
+    for (int i = 0; i <= extra && clear; i++) {
+      clear = !occupied[cell(x + (axis == 0) * i, y + (axis == 1) * i, z + (axis == 2) * i)];
+    }
+    if (!clear) continue;
+
+    for (int i = 0; i <= extra; i++) {
+      occupied[cell(x + (axis == 0) * i, y + (axis == 1) * i, z + (axis == 2) * i)] = true;
+    }
+
+    std::printf("%d,%d,%d~%d,%d,%d\n", x, y, z, x + end[0], y + end[1], z + end[2]);
+    ++placed;
+  }
+}
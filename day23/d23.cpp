@@ -1,26 +1,25 @@
 #include <algorithm>
 #include <array>
-#include <fstream>
-#include <iostream>
 #include <queue>
-#include <string>
+#include <string_view>
 #include <vector>
 
+#include "counters.h"
+#include "grid.h"
+#include "input.h"
+#include "phase.h"
+#include "solver.h"
+#include "work_stealing.h"
+
+namespace d23 {
+
 enum Direction : std::uint8_t { N, E, S, W };
 const std::array<char, 4> direction_slopes{'^', '>', 'v', '<'};
 
 const std::array<Direction, 4> inverse_direction{S, W, N, E};
 
-constexpr std::array<std::pair<int, int>, 4> offsets = {
-  std::make_pair(0, -1),
-  std::make_pair(1, 0),
-  std::make_pair(0, 1),
-  std::make_pair(-1, 0)
-};
-
 struct Vertex {
-  int x;
-  int y;
+  aoc::Grid::Index pos;
   std::vector<int> edges;
   bool visited;
 };
@@ -33,67 +32,66 @@ struct Edge {
 
 class Graph {
 public:
-  Graph(const std::vector<std::string>&, bool directed);
+  Graph(const std::vector<std::string_view>&, bool directed);
 
   // Recursive method which finds the longest path from start to end in the graph.
   int find_longest_path(Vertex* current = nullptr);
 
 private:
   Vertex* start_, *end_;
-  int width_, height_;
   std::vector<Vertex> vertices_;
   std::vector<Edge> edges_;
-  std::vector<std::string> grid_;
+
+  // Walled in all round, which also stops the walks off the top and bottom at the start
+  // and end.
+  aoc::Grid grid_;
   bool directed_;
 
   void calculate_edge_weights(Vertex*, Direction);
 };
 
-Graph::Graph(const std::vector<std::string>& grid, bool directed)
-  : grid_(grid), directed_(directed) {
+Graph::Graph(const std::vector<std::string_view>& grid, bool directed)
+  : grid_(grid, '#'), directed_(directed) {
 
   // First create a vector of all vertices.
-  width_ = static_cast<int>(grid[0].size());
-  height_ = static_cast<int>(grid.size());
+  const int width = grid_.width();
+  const int height = grid_.height();
 
   // Find the start and end vertices.
-  for (int x = 0; x < width_; x++) {
-    if (grid[0][x] == '.') vertices_.push_back(Vertex{x, 0});
-    if (grid.back()[x] == '.') vertices_.push_back(Vertex{x, height_ - 1});
+  for (int x = 0; x < width; x++) {
+    if (grid[0][x] == '.') vertices_.push_back(Vertex{grid_.index(x, 0)});
+    if (grid.back()[x] == '.') vertices_.push_back(Vertex{grid_.index(x, height - 1)});
   }
 
   // If this is a directed graph then create all other vertices based on the slopes.
   // If not then clear the slopes and instead create vertices at junctions.
-  const auto is_junction = [this] (int x, int y) {
+  const auto is_junction = [this] (aoc::Grid::Index pos) {
     // This location is a junction if it has three or more empty neighbours.
     int num_empty = 0;
     for (Direction d : {N, E, S, W}) {
-      const auto& offset = offsets[d];
-      int next_x = x + offset.first;
-      int next_y = y + offset.second;
-      if (next_x < 0 || next_x >= width_ || next_y < 0 || next_y >= height_) continue;
-      num_empty += grid_[next_y][next_x] != '#';
+      num_empty += grid_[pos + grid_.offsets()[d]] != '#';
     }
     return num_empty >= 3;
   };
 
-  for (int y = 1; y < height_; y++) {
-    for (int x = 0; x < width_; x++) {
+  for (int y = 1; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      const aoc::Grid::Index pos = grid_.index(x, y);
       char c = grid[y][x];
       if (c != '.' && c != '#') {
         if (directed) {
-          vertices_.push_back(Vertex{x, y});
+          vertices_.push_back(Vertex{pos});
         }
         else {
-          grid_[y][x] = '.';
+          grid_[pos] = '.';
         }
       }
 
       if (!directed && c == '.') {
         // Check whether this is a junction.
-        if (is_junction(x, y)) {
-          vertices_.push_back(Vertex{x, y});
-          grid_[y][x] = 'o';
+        if (is_junction(pos)) {
+          vertices_.push_back(Vertex{pos});
+          grid_[pos] = 'o';
         }
       }
     }
@@ -111,23 +109,17 @@ Graph::Graph(const std::vector<std::string>& grid, bool directed)
 void Graph::calculate_edge_weights(Vertex* v, Direction d) {
 
   struct StepNode {
-    int x;
-    int y;
+    aoc::Grid::Index pos;
     int steps_taken;
     Direction prev_dir;
   };
 
-  auto offset = offsets[d];
-  int next_x = v->x + offset.first;
-  int next_y = v->y + offset.second;
-
-  // If we're off the grid then stop here (probably the end vertex?).
-  if (next_x < 0 || next_x >= width_ || next_y < 0 || next_y >= height_) return;
-
-  if (grid_[next_y][next_x] == '#') return;
+  // If we're off the grid then this is the border (probably the end vertex?).
+  const aoc::Grid::Index first = v->pos + grid_.offsets()[d];
+  if (grid_[first] == '#') return;
 
   std::queue<StepNode> todo;
-  todo.push(StepNode{next_x, next_y, 1, d});
+  todo.push(StepNode{first, 1, d});
 
   // Keep stepping until we have reached all child vertices.
   while (!todo.empty()) {
@@ -136,10 +128,10 @@ void Graph::calculate_edge_weights(Vertex* v, Direction d) {
 
     // If we've reached another vertex then add the complete edge and kick off an edge
     // weight calc for that one.
-    char c = grid_[current.y][current.x];
+    char c = grid_[current.pos];
     if (c != '.' && c != '#') {
       const auto it = std::find_if(vertices_.begin(), vertices_.end(), [current] (const auto& v) {
-        return v.x == current.x && v.y == current.y;
+        return v.pos == current.pos;
       });
 
       Vertex* end = &vertices_[it - vertices_.begin()];
@@ -171,7 +163,7 @@ void Graph::calculate_edge_weights(Vertex* v, Direction d) {
     }
 
     // If we've reached the end then stop.
-    if (current.x == end_->x && current.y == end_->y) {
+    if (current.pos == end_->pos) {
       // Add an edge.
       edges_.push_back(Edge{v, end_, current.steps_taken});
       v->edges.push_back(edges_.size() - 1);
@@ -182,18 +174,14 @@ void Graph::calculate_edge_weights(Vertex* v, Direction d) {
     for (const auto d : {N, E, S, W}) {
       if (d == inverse_direction[current.prev_dir]) continue;
       
-      offset = offsets[d];
-      next_x = current.x + offset.first;
-      next_y = current.y + offset.second;
-      if (next_x < 0 || next_x >= width_ || next_y < 0 || next_y >= height_) continue;
-
-      c = grid_[next_y][next_x];
+      const aoc::Grid::Index next = current.pos + grid_.offsets()[d];
+      c = grid_[next];
       if (c == '#') continue;
 
       // If it's a vertex but the slope is pointing the wrong way then skip.
       if (c == direction_slopes[inverse_direction[d]]) continue;
 
-      todo.push(StepNode{next_x, next_y, current.steps_taken + 1, d});
+      todo.push(StepNode{next, current.steps_taken + 1, d});
     }
   }
 }
@@ -239,24 +227,52 @@ int Graph::find_longest_path(Vertex* current) {
 
 // Plan: turn the map into a tree structure where the vertices are the downward slopes we
 // can traverse and the edges are the distance between each vertex.
-int main() {
-  std::ifstream fs("input.txt");
-  std::vector<std::string> grid;
-  std::string line;
-  while (std::getline(fs, line)) {
+aoc::Answer solve(std::string_view input) {
+  aoc::PhaseTimer timer("parse");
+
+  std::vector<std::string_view> grid;
+  for (std::string_view line : aoc::Lines(input)) {
     grid.push_back(line);
   }
 
-  Graph directed_graph(grid, true);
+  timer.stop();
+
+  // Each part builds its own graph from the (read only) grid so they can run side by side.
+  int p1, p2;
+  aoc::parallel_invoke(
+    [&] {
+      aoc::PhaseTimer phase("P1", aoc::PhaseScope::Thread);
+
+      aoc::PhaseTimer detail("P1/build_graph", aoc::PhaseScope::Thread);
+      Graph directed_graph(grid, true);
+
+      // The problem now becomes finding the longest path from the start node to the end.
+      detail.next("P1/longest_path");
+      aoc::PerfCounters counters("P1/longest_path");
+      p1 = directed_graph.find_longest_path();
+    },
+    [&] {
+      // I think part 2 can be framed as a modification to part 1:
+      // * The slopes are no longer vertices, instead every "junction" where two or more
+      //   paths meet is now a vertex.
+      // * Edges can only be traversed once but can go in either direction.
+      aoc::PhaseTimer phase("P2", aoc::PhaseScope::Thread);
+
+      aoc::PhaseTimer detail("P2/build_graph", aoc::PhaseScope::Thread);
+      Graph undirected_graph(grid, false);
+
+      detail.next("P2/longest_path");
+      aoc::PerfCounters counters("P2/longest_path");
+      p2 = undirected_graph.find_longest_path();
+    });
+
+  return {p1, p2};
+}
 
-  // The problem now becomes finding the longest path from the start node to the end.
-  const int p1 = directed_graph.find_longest_path();
+}
 
-  // I think part 2 can be framed as a modification to part 1:
-  // * The slopes are no longer vertices, instead every "junction" where two or more paths
-  //   meet is now a vertex.
-  // * Edges can only be traversed once but can go in either direction.
-  Graph undirected_graph(grid, false);
-  const int p2 = undirected_graph.find_longest_path();
-  std::cout << "P1: " << p1 << ", P2: " << p2 << "\n";
+#ifndef AOC_LIBRARY
+int main(int argc, char** argv) {
+  return aoc::solver_main(argc, argv, d23::solve);
 }
+#endif
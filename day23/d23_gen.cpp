@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "generate.h"
+
+// Generates a hiking map like the real one: a 6 x 6 lattice of junctions joined by narrow
+// corridors, with slopes on every arm of every junction pointing right or down. The path
+// enters at the top left and leaves at the bottom right.
+//
+// Corridors get a random detour so that the edge weights vary. Detours stay inside their
+// own band of the map (away from the other corridors) so they never touch.
+// Scaling grows the number of cells, so the side grows with the square root of the scale.
+// The junction lattice stays the same size so part 2 remains tractable; the corridors just
+// get longer.
+
+constexpr int lattice_size = 6;
+
+int main(int argc, char** argv) {
+  auto [scale, rng] = aoc::parse_generator_args(argc, argv);
+
+  const int side = std::max(100L, std::lround(141 * std::sqrt(scale)));
+  const int spacing = (side - 2) / lattice_size;
+  const int band = spacing / 3;
+
+  std::vector<std::string> grid(side, std::string(side, '#'));
+  const auto junction = [spacing] (int i) { return 1 + spacing / 2 + i * spacing; };
+
+  // Carve a straight line of open cells between two points (inclusive).
+  const auto carve = [&grid] (int x1, int y1, int x2, int y2) {
+    for (int y = std::min(y1, y2); y <= std::max(y1, y2); y++) {
+      for (int x = std::min(x1, x2); x <= std::max(x1, x2); x++) {
+        grid[y][x] = '.';
+      }
+    }
+  };
+
+  // Carve a corridor from `from` to `to` along one axis with a rectangular detour sticking
+  // out sideways somewhere in the middle third.
+  const auto corridor = [&] (int from, int to, int at, bool horizontal) {
+    const int u = aoc::uniform(rng, from + band + 2, (from + to) / 2 - 1);
+    const int v = aoc::uniform(rng, (from + to) / 2 + 1, to - band - 2);
+    const int d = aoc::uniform(rng, -(band - 2), band - 2);
+    const auto line = [&] (int a1, int b1, int a2, int b2) {
+      if (horizontal) carve(a1, b1, a2, b2);
+      else carve(b1, a1, b2, a2);
+    };
+
+    line(from, at, u, at);
+    line(u, at, u, at + d);
+    line(u, at + d, v, at + d);
+    line(v, at + d, v, at);
+    line(v, at, to, at);
+  };
+
+  for (int j = 0; j < lattice_size; j++) {
+    for (int i = 0; i + 1 < lattice_size; i++) {
+      corridor(junction(i), junction(i + 1), junction(j), true);
+      corridor(junction(i), junction(i + 1), junction(j), false);
+    }
+  }
+
+  // Entrance and exit.
+  const int first = junction(0), last = junction(lattice_size - 1);
+  carve(1, 0, 1, first);
+  carve(1, first, first, first);
+  carve(last, last, side - 2, last);
+  carve(side - 2, last, side - 2, side - 1);
+
+  // Slopes on every arm of every junction.
+  for (int j = 0; j < lattice_size; j++) {
+    for (int i = 0; i < lattice_size; i++) {
+      const int x = junction(i), y = junction(j);
+      if (grid[y][x - 1] == '.') grid[y][x - 1] = '>';
+      if (grid[y][x + 1] == '.') grid[y][x + 1] = '>';
+      if (grid[y - 1][x] == '.') grid[y - 1][x] = 'v';
+      if (grid[y + 1][x] == '.') grid[y + 1][x] = 'v';
+    }
+  }
+
+  for (const auto& row : grid) {
+    std::fwrite(row.data(), 1, row.size(), stdout);
+    std::putchar('\n');
+  }
+}
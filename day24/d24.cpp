@@ -1,14 +1,17 @@
 #include <algorithm>
 #include <array>
-#include <fstream>
-#include <iostream>
 #include <optional>
-#include <ostream>
 #include <queue>
-#include <sstream>
-#include <string>
+#include <string_view>
 #include <vector>
 
+#include "input.h"
+#include "phase.h"
+#include "scan.h"
+#include "solver.h"
+
+namespace d24 {
+
 struct Point {
   double x;
   double y;
@@ -26,12 +29,6 @@ struct Hail {
   Vector vel;
 };
 
-std::ostream& operator<<(std::ostream& os, const Hail& h) {
-  os << h.pos.x << " " << h.pos.y << " " << h.pos.z << ", "
-     << h.vel.i << " " << h.vel.j << " " << h.vel.k;
-  return os;
-}
-
 // Solve two simultaneous equations in two variables to find the path intersection
 std::optional<Point> paths_will_cross(const Hail& h1, const Hail& h2) {
   // Solve equations:
@@ -75,49 +72,33 @@ bool crossover_in_range(const Point& p) {
   return p.x >= r[0] && p.x <= r[1] && p.y >= r[0] && p.y <= r[1];
 }
 
-int main() {
-  std::ifstream fs("input.txt");
-  std::vector<Hail> hailstones;
-  std::string line, token;
-  while (std::getline(fs, line)) {
+aoc::Answer solve(std::string_view input) {
+  aoc::PhaseTimer timer("parse");
 
-    std::replace(line.begin(), line.end(), ',', ' ');
-    std::replace(line.begin(), line.end(), '@', ' ');
+  // Everything in the input is an integer (and well within double precision), so scan them
+  // as such, a column per coordinate, rather than parsing doubles.
+  std::vector<std::int64_t> px, py, pz, vx, vy, vz;
+  const std::size_t num_hailstones = aoc::scan_columns(input, px, py, pz, vx, vy, vz);
 
-    Hail h;
-
-    std::stringstream ss(line);
-    ss >> token; h.pos.x = std::stod(token);
-    ss >> token; h.pos.y = std::stod(token);
-    ss >> token; h.pos.z = std::stod(token);
-
-    ss >> token; h.vel.i = std::stod(token);
-    ss >> token; h.vel.j = std::stod(token);
-    ss >> token; h.vel.k = std::stod(token);
-
-    hailstones.push_back(h);
+  std::vector<Hail> hailstones(num_hailstones);
+  for (std::size_t i = 0; i < num_hailstones; i++) {
+    auto& h = hailstones[i];
+    h.pos = Point{static_cast<double>(px[i]), static_cast<double>(py[i]), static_cast<double>(pz[i])};
+    h.vel = Vector{static_cast<double>(vx[i]), static_cast<double>(vy[i]), static_cast<double>(vz[i])};
   }
 
+  timer.next("P1");
+
   // For Part 1 we want to find the intersection in the 2D plane (ignore z).
   int num_intersections = 0;
   for (std::size_t i = 0; i < hailstones.size(); i++) {
     for (std::size_t j = i + 1; j < hailstones.size(); j++) {
-      std::cout << "Considering:\n" << hailstones[i] << "\n" << hailstones[j] << "\n";
-
       const auto res = paths_will_cross(hailstones[i], hailstones[j]);
-      if (!res) {
-        std::cout << "No future cross-over\n";
-        continue;
-      }
-
-      const auto p = *res;
-      std::cout << "Intersection at: " << p.x << ", " << p.y << ", " << p.z << "\n";
-
-      if (crossover_in_range(p)) ++num_intersections;
+      if (res && crossover_in_range(*res)) ++num_intersections;
     }
   }
 
-  std::cout << "P1: " << num_intersections << "\n";
+  timer.stop();
 
   // Part 2 is a different kettle of fish.
   // We're effectively in a system of equations which are massively over-constrained.
@@ -126,4 +107,13 @@ int main() {
   // They aren't linear simultaneous equations so not completely obvious how to solve them.
   // Rather than pulling in a dependency to solve them I took a shortcut and used the
   // Python SymPy module which solves them rather handily (see "p2.py").
+  return {num_intersections, std::nullopt};
+}
+
+}
+
+#ifndef AOC_LIBRARY
+int main(int argc, char** argv) {
+  return aoc::solver_main(argc, argv, d24::solve);
 }
+#endif
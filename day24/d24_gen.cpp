@@ -0,0 +1,48 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+#include "generate.h"
+
+// Generates hailstones like the real ones: every hailstone crosses the path of a hidden rock
+// (which is what part 2 of the puzzle asks for), with positions in the 1e14 range and
+// velocities in the hundreds.
+// Scaling grows the number of hailstones.
+
+int main(int argc, char** argv) {
+  auto [scale, rng] = aoc::parse_generator_args(argc, argv);
+
+  const auto num_hailstones = std::max(3L, std::lround(300 * scale));
+
+  std::array<std::int64_t, 3> rock_position, rock_velocity;
+  for (int i = 0; i < 3; i++) {
+    rock_position[i] = aoc::uniform<std::int64_t>(rng, 200000000000000, 300000000000000);
+    rock_velocity[i] = aoc::uniform<std::int64_t>(rng, -100, 100);
+  }
+
+  for (long n = 0; n < num_hailstones; n++) {
+    // Pick when the rock hits the hailstone and work back to where the hailstone starts,
+    // trying again if it would start at a negative coordinate.
+    std::array<std::int64_t, 3> position, velocity;
+    bool valid = false;
+    while (!valid) {
+      const auto t = aoc::uniform<std::int64_t>(rng, 10000000000, 400000000000);
+      valid = true;
+      for (int i = 0; i < 3; i++) {
+        do {
+          velocity[i] = aoc::uniform<std::int64_t>(rng, -300, 300);
+        } while (velocity[i] == 0 || velocity[i] == rock_velocity[i]);
+
+        position[i] = rock_position[i] + (rock_velocity[i] - velocity[i]) * t;
+        valid = valid && position[i] > 0;
+      }
+    }
+
+    std::printf("%lld, %lld, %lld @ %lld, %lld, %lld\n",
+      static_cast<long long>(position[0]), static_cast<long long>(position[1]),
+      static_cast<long long>(position[2]), static_cast<long long>(velocity[0]),
+      static_cast<long long>(velocity[1]), static_cast<long long>(velocity[2]));
+  }
+}
@@ -1,18 +1,18 @@
 #include <algorithm>
-#include <array>
-#include <cassert>
-#include <fstream>
-#include <iostream>
-#include <ostream>
 #include <queue>
+#include <random>
 #include <set>
-#include <sstream>
-#include <string>
+#include <string_view>
 #include <vector>
 
+#include "input.h"
+#include "labels.h"
+#include "phase.h"
+#include "solver.h"
+
+namespace d25 {
+
 struct Vertex {
-  bool initialised;
-  std::string label;
   std::vector<int> edge_indices;
   Vertex* parent;
 };
@@ -28,16 +28,6 @@ struct Edge {
   }
 };
 
-std::ostream& operator<<(std::ostream& os, const Edge& e) {
-  os << e.end1->label << " --> " << e.end2->label;
-  return os;
-}
-
-int label_to_index(const std::string& label) {
-  assert(label.size() == 3);
-  return (label[0] - 'a') * 26 * 26 + (label[1] - 'a') * 26 + (label[2] - 'a');
-}
-
 void shortest_path_with_stats(Vertex* v1, Vertex* v2, std::vector<Edge>& edges) {
   // The graph isn't weighted so when we first encounter a node we have the shortest path to it
   // (assuming a BFS).
@@ -106,45 +96,45 @@ int component_size(const Vertex* v, const std::vector<Edge>& edges) {
   return considered.size();
 }
 
-void reset_vertices(std::array<Vertex, 26*26*26>& vertices) {
+void reset_vertices(std::vector<Vertex>& vertices) {
   for (auto& v : vertices) v.parent = nullptr;
 }
 
-int main() {
-  srand(time(NULL));
+aoc::Answer solve(std::string_view input) {
+  aoc::PhaseTimer timer("parse");
 
-  std::ifstream fs("input.txt");
-  std::array<Vertex, 26*26*26> vertices;
-  vertices.fill(Vertex{false});
-  std::vector<Edge> edges;
+  static constexpr std::string_view delims = " :";
 
-  std::string line, token;
-  while (std::getline(fs, line)) {
+  // Give every component a dense id first, so that all of the vertices exist before any
+  // edges point at them.
+  aoc::LabelInterner ids(aoc::lowercase, 3);
+  for (std::string_view line : aoc::Lines(input)) {
+    for (auto token = aoc::next_token(line, delims); !token.empty(); token = aoc::next_token(line, delims)) {
+      ids.intern(token);
+    }
+  }
 
-    std::replace(line.begin(), line.end(), ':', ' ');
+  std::vector<Vertex> vertices(ids.size());
+  std::vector<Edge> edges;
 
-    std::stringstream ss(line);
-    ss >> token;
+  for (std::string_view line : aoc::Lines(input)) {
+    auto token = aoc::next_token(line, delims);
 
-    Vertex* end1 = &vertices[label_to_index(token)];
-    end1->initialised = true;
-    end1->label = token;
+    Vertex* end1 = &vertices[ids.find(token)];
 
-    ss >> token;
-    while (ss) {
-      Vertex* end2 = &vertices[label_to_index(token)];
-      end2->initialised = true;
-      end2->label = token;
+    for (token = aoc::next_token(line, delims); !token.empty(); token = aoc::next_token(line, delims)) {
+      Vertex* end2 = &vertices[ids.find(token)];
 
       // Add bidirectional edge.
       edges.push_back(Edge{end1, end2});
 
       end1->edge_indices.push_back(edges.size() - 1);
       end2->edge_indices.push_back(edges.size() - 1);
-      ss >> token;
     }
   }
 
+  timer.next("P1");
+
   // New plan:
   // Pick pairs of vertices at random and find the shortest path between them, keeping track
   // of how many "hits" each edge gets over time.
@@ -153,20 +143,18 @@ int main() {
   // more hits over time.
   // This will be more effective if the two components are roughly the same size.
   std::vector<Vertex*> vs;
-  for (std::size_t i = 0; i < vertices.size(); i++) {
-    if (!vertices[i].initialised) continue;
-    vs.push_back(&vertices[i]);
-  }
+  for (auto& v : vertices) vs.push_back(&v);
 
+  std::mt19937 rng(std::random_device{}());
   int i = 0;
   Vertex* v1, *v2;
   while (i < 1000) {
     // Select two vertices at random.
-    v1 = vs[rand() % vs.size()];
+    v1 = vs[rng() % vs.size()];
 
     // Ensure we end up with a different vertex for v2.
     v2 = v1;
-    while (v2 == v1) v2 = vs[rand() % vs.size()];
+    while (v2 == v1) v2 = vs[rng() % vs.size()];
 
     reset_vertices(vertices);
     shortest_path_with_stats(v1, v2, edges);
@@ -185,15 +173,21 @@ int main() {
 
   // Remove the most "important" edges.
   std::vector<Edge*> top3(es.end() - 3, es.end());
-  for (auto* e : top3) {
-    std::cout << *e << " hits: " << e->hits << "\n";
-    e->removed = true;
-  }
+  for (auto* e : top3) e->removed = true;
 
   // Calc size of each component.
   int size1 = component_size(top3[0]->end1, edges);
   int size2 = component_size(top3[0]->end2, edges);
 
-  std::cout << "Components: " << size1 << " " << size2 << "\n";
-  std::cout << "P1: " << size1 * size2 << "\n";
+  timer.stop();
+
+  return {size1 * size2, std::nullopt};
+}
+
+}
+
+#ifndef AOC_LIBRARY
+int main(int argc, char** argv) {
+  return aoc::solver_main(argc, argv, d25::solve);
 }
+#endif
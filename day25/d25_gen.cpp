@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "generate.h"
+
+// Generates a wiring diagram like the real one: two well connected halves (average degree
+// around 4.4) joined by exactly three wires.
+// Scaling grows the number of components in each half. The solver only accepts three letter
+// labels, which caps the scale at around 5.
+
+int main(int argc, char** argv) {
+  auto [scale, rng] = aoc::parse_generator_args(argc, argv);
+
+  const auto half = std::max(4L, std::lround(750 * scale));
+  if (2 * half > 26 * 26 * 26 / 2) {
+    std::fprintf(stderr, "Scale too large: not enough three letter labels\n");
+    return EXIT_FAILURE;
+  }
+
+  aoc::LabelPool pool("abcdefghijklmnopqrstuvwxyz", 3);
+  std::vector<std::string> labels;
+  for (long i = 0; i < 2 * half; i++) labels.push_back(pool.next(rng));
+
+  // Each half starts out as a random tree (so it's connected) and then gets more random
+  // wires until the degree is right.
+  std::set<std::pair<long, long>> wires;
+  const auto add_wire = [&wires] (long a, long b) {
+    if (a == b) return;
+    wires.insert({std::min(a, b), std::max(a, b)});
+  };
+
+  for (long offset : {0L, half}) {
+    for (long i = 1; i < half; i++) add_wire(offset + i, offset + aoc::uniform(rng, 0L, i - 1));
+    while (static_cast<long>(wires.size()) < (offset + half) * 22 / 10) {
+      add_wire(offset + aoc::uniform(rng, 0L, half - 1), offset + aoc::uniform(rng, 0L, half - 1));
+    }
+  }
+
+  while (static_cast<long>(wires.size()) < 2 * half * 22 / 10 + 3) {
+    add_wire(aoc::uniform(rng, 0L, half - 1), half + aoc::uniform(rng, 0L, half - 1));
+  }
+
+  // List each wire once, against a randomly chosen end.
+  std::vector<std::vector<long>> connections(2 * half);
+  for (auto [a, b] : wires) {
+    if (aoc::uniform(rng, 0, 1)) std::swap(a, b);
+    connections[a].push_back(b);
+  }
+
+  std::vector<long> order(2 * half);
+  for (long i = 0; i < 2 * half; i++) order[i] = i;
+  std::shuffle(order.begin(), order.end(), rng);
+
+  for (auto i : order) {
+    if (connections[i].empty()) continue;
+    std::printf("%s:", labels[i].c_str());
+    for (auto j : connections[i]) std::printf(" %s", labels[j].c_str());
+    std::printf("\n");
+  }
+}
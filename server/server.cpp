@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+#include "solvers.h"
+#include "thread_pool.h"
+
+// Answers a stream of puzzle jobs from a pool of threads, without paying process start up
+// and file IO for every input.
+//
+// Usage: aoc_server [-j threads] [-s socket]
+//
+// Jobs come in on stdin (answers go to stdout) or, with -s, on any number of connections
+// to a Unix socket at the given path. A job is a header line followed by the raw input:
+//
+//   <id> <solver> <input length in bytes>\n<input>
+//
+// e.g. "7 d17 19881\n" and then the 19881 bytes of the day 17 input. Each job gets one line
+// back once it's solved, in whatever order they finish:
+//
+//   <id> <P1> <P2>\n        ("-" for a missing P2)
+//   <id> error <reason>\n
+//
+// The solvers trust their input, so a malformed one can take the whole server down.
+
+namespace {
+
+// Buffered reads from a file descriptor.
+class Reader {
+public:
+  explicit Reader(int fd) : fd_(fd) {}
+
+  // Reads up to (and drops) the next newline. False at end of input.
+  bool read_line(std::string& line) {
+    line.clear();
+    while (true) {
+      const auto nl = buf_.find('\n', pos_);
+      if (nl != std::string::npos) {
+        line.append(buf_, pos_, nl - pos_);
+        pos_ = nl + 1;
+        return true;
+      }
+
+      line.append(buf_, pos_, std::string::npos);
+      pos_ = buf_.size();
+      if (!fill()) return false;
+    }
+  }
+
+  bool read_exact(std::string& out, std::size_t len) {
+    out.clear();
+    out.reserve(len);
+    while (out.size() < len) {
+      if (pos_ == buf_.size() && !fill()) return false;
+      const auto n = std::min(len - out.size(), buf_.size() - pos_);
+      out.append(buf_, pos_, n);
+      pos_ += n;
+    }
+    return true;
+  }
+
+private:
+  int fd_;
+  std::string buf_;
+  std::size_t pos_ = 0;
+
+  bool fill() {
+    char chunk[1 << 16];
+    ssize_t n;
+    do {
+      n = read(fd_, chunk, sizeof(chunk));
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) return false;
+
+    buf_.assign(chunk, n);
+    pos_ = 0;
+    return true;
+  }
+};
+
+// Where the answers for one stream of jobs go. Jobs hold on to it so it outlives the
+// reader, and it closes the connection (if it owns it) once the last one is answered.
+class Responder {
+public:
+  Responder(int fd, bool owns_fd) : fd_(fd), owns_fd_(owns_fd) {}
+
+  ~Responder() {
+    if (owns_fd_) close(fd_);
+  }
+
+  void send(const std::string& line) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const char* p = line.data();
+    std::size_t remaining = line.size();
+    while (remaining > 0) {
+      const ssize_t n = write(fd_, p, remaining);
+      if (n < 0 && errno == EINTR) continue;
+
+      // The other end has gone away; nothing more we can do for it.
+      if (n <= 0) return;
+
+      p += n;
+      remaining -= n;
+    }
+  }
+
+private:
+  int fd_;
+  bool owns_fd_;
+  std::mutex mutex_;
+};
+
+void serve(int in_fd, std::shared_ptr<Responder> responder, aoc::ThreadPool& pool) {
+  Reader reader(in_fd);
+  std::string header;
+  while (reader.read_line(header)) {
+    if (header.empty()) continue;
+
+    char id[64], name[16];
+    unsigned long long len;
+    if (std::sscanf(header.c_str(), "%63s %15s %llu", id, name, &len) != 3) {
+      responder->send("? error malformed header\n");
+      return;
+    }
+
+    auto input = std::make_shared<std::string>();
+    if (!reader.read_exact(*input, len)) {
+      responder->send(std::string(id) + " error truncated input\n");
+      return;
+    }
+
+    const aoc::SolverEntry* solver = aoc::find_solver(name);
+    if (!solver) {
+      responder->send(std::string(id) + " error unknown solver " + name + "\n");
+      continue;
+    }
+
+    pool.submit([responder, input, solver, id = std::string(id)] {
+      const aoc::Answer answer = solver->solve(*input);
+      std::string line = id + " " + (answer.p1 ? std::to_string(*answer.p1) : "-") + " ";
+      line += answer.p2 ? std::to_string(*answer.p2) : "-";
+      line += "\n";
+      responder->send(line);
+    });
+  }
+}
+
+int listen_on(const char* path) {
+  sockaddr_un addr;
+  if (std::strlen(path) >= sizeof(addr.sun_path)) {
+    std::fprintf(stderr, "Socket path too long: %s\n", path);
+    std::exit(EXIT_FAILURE);
+  }
+
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  std::strcpy(addr.sun_path, path);
+
+  // Clear out a socket left behind by a previous run.
+  unlink(path);
+
+  const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0 ||
+      bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      listen(fd, SOMAXCONN) != 0) {
+    std::perror(path);
+    std::exit(EXIT_FAILURE);
+  }
+
+  return fd;
+}
+
+void usage() {
+  std::fprintf(stderr, "Usage: aoc_server [-j threads] [-s socket]\n");
+  std::exit(EXIT_FAILURE);
+}
+
+}
+
+int main(int argc, char** argv) {
+  std::size_t num_threads = std::thread::hardware_concurrency();
+  const char* socket_path = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      const int n = std::atoi(argv[++i]);
+      if (n < 1) usage();
+      num_threads = n;
+    }
+    else if (std::strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      socket_path = argv[++i];
+    }
+    else {
+      usage();
+    }
+  }
+
+  // Clients hanging up early shouldn't kill the server.
+  std::signal(SIGPIPE, SIG_IGN);
+
+  aoc::ThreadPool pool(num_threads);
+
+  if (!socket_path) {
+    serve(STDIN_FILENO, std::make_shared<Responder>(STDOUT_FILENO, false), pool);
+
+    // The pool's destructor finishes off the outstanding jobs.
+    return EXIT_SUCCESS;
+  }
+
+  const int listen_fd = listen_on(socket_path);
+  std::fprintf(stderr, "Listening on %s with %zu threads\n", socket_path, pool.size());
+
+  while (true) {
+    const int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      std::perror("accept");
+      return EXIT_FAILURE;
+    }
+
+    // One reader thread per connection; the solving happens on the pool.
+    std::thread([fd, &pool] { serve(fd, std::make_shared<Responder>(fd, true), pool); }).detach();
+  }
+}
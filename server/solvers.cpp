@@ -0,0 +1,28 @@
+#include <algorithm>
+
+#include "solvers.h"
+
+#define AOC_SOLVERS(X) X(5) X(6) X(8) X(17) X(18) X(19) X(20) X(21) X(22) X(23) X(24) X(25)
+
+#define AOC_DECLARE_SOLVER(n) namespace d##n { aoc::Answer solve(std::string_view input); }
+AOC_SOLVERS(AOC_DECLARE_SOLVER)
+#undef AOC_DECLARE_SOLVER
+
+namespace aoc {
+
+const std::vector<SolverEntry>& all_solvers() {
+#define AOC_SOLVER_ENTRY(n) SolverEntry{"d" #n, d##n::solve},
+  static const std::vector<SolverEntry> solvers = {AOC_SOLVERS(AOC_SOLVER_ENTRY)};
+#undef AOC_SOLVER_ENTRY
+  return solvers;
+}
+
+const SolverEntry* find_solver(std::string_view name) {
+  const auto& solvers = all_solvers();
+  const auto it = std::find_if(solvers.begin(), solvers.end(), [name] (const SolverEntry& s) {
+    return name == s.name;
+  });
+  return it == solvers.end() ? nullptr : &*it;
+}
+
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+#include "solver.h"
+
+namespace aoc {
+
+struct SolverEntry {
+  const char* name;
+  SolveFn solve;
+};
+
+// Every C++ day, in order, named like their executables ("d5", "d17", ...).
+const std::vector<SolverEntry>& all_solvers();
+
+// nullptr if there's no solver with that name.
+const SolverEntry* find_solver(std::string_view name);
+
+}